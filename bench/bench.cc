@@ -0,0 +1,574 @@
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cbor.h"
+#include "corpus.h"
+#include "indexer.h"
+#include "lexer.h"
+#include "ndjson.h"
+#include "parser.h"
+#include "sax.h"
+#include "simd.h"
+#include "writer.h"
+
+// every allocation in the process goes through these, so a phase can tell
+// how many it made.
+namespace {
+
+std::atomic<std::size_t> allocation_count{0};
+std::atomic<std::size_t> allocation_bytes{0};
+
+auto counted_allocation(std::size_t size) -> void* {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (auto* pointer = std::malloc(size == 0 ? 1 : size))
+        return pointer;
+
+    throw std::bad_alloc();
+}
+
+}
+
+auto operator new(std::size_t size) -> void* {
+    return counted_allocation(size);
+}
+
+auto operator new[](std::size_t size) -> void* {
+    return counted_allocation(size);
+}
+
+auto operator delete(void* pointer) noexcept -> void {
+    std::free(pointer);
+}
+
+auto operator delete[](void* pointer) noexcept -> void {
+    std::free(pointer);
+}
+
+auto operator delete(void* pointer, std::size_t) noexcept -> void {
+    std::free(pointer);
+}
+
+auto operator delete[](void* pointer, std::size_t) noexcept -> void {
+    std::free(pointer);
+}
+
+namespace {
+
+enum class Phase {
+    // structural index only.
+    Index,
+    // JsonParser::validate, grammar and utf-8 without building anything.
+    Validate,
+    // tokens only, through JsonLexer.
+    Lex,
+    // full grammar through JsonSaxParser, no values built.
+    Parse,
+    // JsonParser::parse, or parse_many on one thread for ndjson.
+    Dom,
+    // JsonValue::serialize of an already parsed tree.
+    Serialize,
+    // JsonCbor::encode of an already parsed tree.
+    Encode,
+    // JsonCbor::decode of the tree encoded up front.
+    Decode,
+};
+
+constexpr Phase all_phases[] = {Phase::Index, Phase::Validate, Phase::Lex, Phase::Parse, Phase::Dom, Phase::Serialize, Phase::Encode, Phase::Decode};
+
+auto phase_to_string(Phase phase) -> std::string_view {
+    switch (phase) {
+    case Phase::Index:
+        return "index";
+    case Phase::Validate:
+        return "validate";
+    case Phase::Lex:
+        return "lex";
+    case Phase::Parse:
+        return "parse";
+    case Phase::Dom:
+        return "dom";
+    case Phase::Serialize:
+        return "serialize";
+    case Phase::Encode:
+        return "encode";
+    case Phase::Decode:
+        return "decode";
+    }
+
+    return "unknown";
+}
+
+enum class Format {
+    Text,
+    Json,
+    Csv,
+};
+
+struct Options {
+    std::vector<CorpusKind> corpora{CorpusKind::Deep, CorpusKind::Wide, CorpusKind::Numeric, CorpusKind::Strings, CorpusKind::Ndjson};
+    std::vector<std::size_t> sizes{64 << 10, 1 << 20, 16 << 20};
+    std::vector<Phase> phases{std::begin(all_phases), std::end(all_phases)};
+    std::size_t iterations{5};
+    std::uint64_t seed{42};
+    Format format{Format::Text};
+};
+
+struct Measurement {
+    std::string_view corpus;
+    std::size_t bytes;
+    std::size_t documents;
+    std::string_view phase;
+    std::size_t iterations;
+
+    // median over the iterations.
+    double seconds;
+    double mb_per_second;
+    double documents_per_second;
+
+    double allocations_per_document;
+    double allocated_bytes_per_document;
+    std::size_t peak_rss_kib;
+};
+
+volatile std::size_t sink;
+
+// VmHWM of this process in KiB, the peak is reset before every phase when
+// the kernel allows it, otherwise it is the peak of the whole run so far.
+auto peak_rss_kib() -> std::size_t {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+
+    while (std::getline(status, line)) {
+        if (line.starts_with("VmHWM:"))
+            return std::strtoull(line.c_str() + 6, nullptr, 10);
+    }
+
+    rusage usage{};
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    return static_cast<std::size_t>(usage.ru_maxrss);
+}
+
+auto reset_peak_rss() -> void {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+
+    clear_refs << "5";
+}
+
+auto split_lines(std::string_view text) -> std::vector<std::string_view> {
+    std::vector<std::string_view> lines;
+
+    while (not text.empty()) {
+        const auto end = text.find('\n');
+
+        lines.push_back(text.substr(0, end));
+
+        if (end == std::string_view::npos)
+            break;
+
+        text.remove_prefix(end + 1);
+    }
+
+    return lines;
+}
+
+// parsed once up front, for the phases that only measure what is done
+// with the tree.
+// a workload that fails measures the error path instead of the phase, so
+// the whole run stops rather than report numbers for it.
+[[noreturn]] auto fail(std::string_view what, std::string_view message) -> void {
+    std::cerr << "bench: " << what << " failed: " << message << '\n';
+    std::exit(1);
+}
+
+// the variant index, to keep the result alive.
+template<typename T>
+auto checked(const ErrorOr<T>& result, std::string_view what) -> std::size_t {
+    if (const auto* error = std::get_if<JsonError>(&result))
+        fail(what, error->message());
+
+    return result.index();
+}
+
+template<typename T>
+auto value_of(ErrorOr<T>&& result, std::string_view what) -> T {
+    checked(result, what);
+
+    return std::move(std::get<1>(result));
+}
+
+auto parse_documents(std::string_view text, bool is_ndjson) -> std::shared_ptr<std::vector<JsonObject>> {
+    auto documents = std::make_shared<std::vector<JsonObject>>();
+
+    if (is_ndjson) {
+        for (const auto line : split_lines(text))
+            documents->push_back(value_of(JsonParser::parse(line), "parse"));
+    } else {
+        documents->push_back(value_of(JsonParser::parse(text), "parse"));
+    }
+
+    return documents;
+}
+
+// one run of the phase over the whole corpus.
+auto make_workload(const Corpus& corpus, Phase phase) -> std::function<void()> {
+    const std::string_view text = corpus.text;
+    const auto is_ndjson = corpus.kind == CorpusKind::Ndjson;
+
+    switch (phase) {
+    case Phase::Index:
+        return [text] {
+            sink = StructuralIndex::build(text).size();
+        };
+    case Phase::Validate:
+        return [text, is_ndjson] {
+            if (not is_ndjson) {
+                sink = checked(JsonParser::validate(text), "validate");
+                return;
+            }
+
+            for (const auto line : split_lines(text))
+                sink = checked(JsonParser::validate(line), "validate");
+        };
+    case Phase::Lex:
+        return [text] {
+            JsonLexer lexer(text);
+            std::size_t tokens = 0;
+
+            for (auto token = lexer.get_token(); token.type() != TokenType::EndOfFile; token = lexer.get_token()) {
+                if (token.type() == TokenType::Garbage)
+                    fail("lex", token.to_string());
+
+                tokens++;
+            }
+
+            sink = tokens;
+        };
+    case Phase::Parse:
+        return [text, is_ndjson] {
+            JsonSaxHandler handler;
+
+            if (not is_ndjson) {
+                sink = checked(JsonSaxParser<JsonSaxHandler>::parse(text, handler), "parse");
+                return;
+            }
+
+            for (const auto line : split_lines(text))
+                sink = checked(JsonSaxParser<JsonSaxHandler>::parse(line, handler), "parse");
+        };
+    case Phase::Dom:
+        return [text, is_ndjson] {
+            if (not is_ndjson) {
+                sink = checked(JsonParser::parse(text), "dom");
+                return;
+            }
+
+            const auto result = parse_many(text, NdjsonOptions{.threads = 1});
+
+            if (result.error_count != 0)
+                fail("dom", std::to_string(result.error_count) + " malformed records");
+
+            sink = result.record_count;
+        };
+    case Phase::Serialize: {
+        auto documents = parse_documents(text, is_ndjson);
+
+        return [documents] {
+            for (const auto& document : *documents)
+                sink = document.serialize().length();
+        };
+    }
+    case Phase::Encode: {
+        auto documents = parse_documents(text, is_ndjson);
+
+        return [documents] {
+            for (const auto& document : *documents)
+                sink = JsonCbor::encode(document).length();
+        };
+    }
+    case Phase::Decode: {
+        const auto documents = parse_documents(text, is_ndjson);
+        auto encoded = std::make_shared<std::vector<std::string>>();
+
+        for (const auto& document : *documents)
+            encoded->push_back(JsonCbor::encode(document));
+
+        return [encoded] {
+            for (const auto& payload : *encoded)
+                sink = checked(JsonCbor::decode(payload), "decode");
+        };
+    }
+    }
+
+    return [] {};
+}
+
+auto measure(const Corpus& corpus, Phase phase, const Options& options) -> Measurement {
+    auto workload = make_workload(corpus, phase);
+
+    // warm up caches and the allocator, and let the lazy simd detection run.
+    workload();
+
+    reset_peak_rss();
+
+    std::vector<double> seconds;
+    std::size_t allocations = 0;
+    std::size_t allocated_bytes = 0;
+
+    for (std::size_t i = 0; i < options.iterations; i++) {
+        const auto count_before = allocation_count.load();
+        const auto bytes_before = allocation_bytes.load();
+        const auto start = std::chrono::steady_clock::now();
+
+        workload();
+
+        const auto end = std::chrono::steady_clock::now();
+
+        allocations += allocation_count.load() - count_before;
+        allocated_bytes += allocation_bytes.load() - bytes_before;
+
+        seconds.push_back(std::chrono::duration<double>(end - start).count());
+    }
+
+    std::sort(seconds.begin(), seconds.end());
+
+    const auto median = seconds[seconds.size() / 2];
+    const auto runs = static_cast<double>(options.iterations);
+    const auto documents = static_cast<double>(corpus.documents);
+
+    return Measurement{
+        .corpus = corpus_kind_to_string(corpus.kind),
+        .bytes = corpus.text.length(),
+        .documents = corpus.documents,
+        .phase = phase_to_string(phase),
+        .iterations = options.iterations,
+        .seconds = median,
+        .mb_per_second = static_cast<double>(corpus.text.length()) / (1 << 20) / median,
+        .documents_per_second = documents / median,
+        .allocations_per_document = static_cast<double>(allocations) / runs / documents,
+        .allocated_bytes_per_document = static_cast<double>(allocated_bytes) / runs / documents,
+        .peak_rss_kib = peak_rss_kib(),
+    };
+}
+
+auto report(const Measurement& measurement, Format format) -> void {
+    switch (format) {
+    case Format::Text: {
+        char line[256];
+
+        std::snprintf(line, sizeof(line), "%-8s %10zu %-10s %10.2f MB/s %12.1f docs/s %12.1f allocs/doc %10zu KiB\n",
+                std::string(measurement.corpus).c_str(), measurement.bytes, std::string(measurement.phase).c_str(),
+                measurement.mb_per_second, measurement.documents_per_second,
+                measurement.allocations_per_document, measurement.peak_rss_kib);
+
+        std::cout << line;
+        break;
+    }
+    case Format::Json: {
+        // one object per line, so runs can be diffed and concatenated.
+        JsonWriter writer(std::cout);
+
+        writer.start_object();
+        writer.write_key("corpus");
+        writer.write_string(measurement.corpus);
+        writer.write_key("bytes");
+        writer.write_uint64(measurement.bytes);
+        writer.write_key("documents");
+        writer.write_uint64(measurement.documents);
+        writer.write_key("phase");
+        writer.write_string(measurement.phase);
+        writer.write_key("iterations");
+        writer.write_uint64(measurement.iterations);
+        writer.write_key("seconds");
+        writer.write_number(measurement.seconds);
+        writer.write_key("mb_per_second");
+        writer.write_number(measurement.mb_per_second);
+        writer.write_key("documents_per_second");
+        writer.write_number(measurement.documents_per_second);
+        writer.write_key("allocations_per_document");
+        writer.write_number(measurement.allocations_per_document);
+        writer.write_key("allocated_bytes_per_document");
+        writer.write_number(measurement.allocated_bytes_per_document);
+        writer.write_key("peak_rss_kib");
+        writer.write_uint64(measurement.peak_rss_kib);
+        writer.end_object();
+        writer.flush();
+
+        std::cout << '\n';
+        break;
+    }
+    case Format::Csv:
+        std::cout << measurement.corpus << ',' << measurement.bytes << ',' << measurement.documents << ','
+            << measurement.phase << ',' << measurement.iterations << ',' << measurement.seconds << ','
+            << measurement.mb_per_second << ',' << measurement.documents_per_second << ','
+            << measurement.allocations_per_document << ',' << measurement.allocated_bytes_per_document << ','
+            << measurement.peak_rss_kib << '\n';
+        break;
+    }
+}
+
+auto split_list(std::string_view list) -> std::vector<std::string_view> {
+    std::vector<std::string_view> items;
+
+    while (true) {
+        const auto comma = list.find(',');
+
+        items.push_back(list.substr(0, comma));
+
+        if (comma == std::string_view::npos)
+            return items;
+
+        list.remove_prefix(comma + 1);
+    }
+}
+
+// "4096", "64k", "16m".
+auto parse_size(std::string_view text) -> std::optional<std::size_t> {
+    std::size_t value = 0;
+
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.length(), value);
+
+    if (error != std::errc{})
+        return std::nullopt;
+
+    const auto suffix = text.substr(end - text.data());
+
+    if (suffix.empty())
+        return value;
+
+    if (suffix == "k" or suffix == "K")
+        return value << 10;
+
+    if (suffix == "m" or suffix == "M")
+        return value << 20;
+
+    return std::nullopt;
+}
+
+auto print_usage() -> void {
+    std::cerr << "usage: bench [--corpus=deep,wide,numeric,strings,ndjson] [--size=64k,1m,16m]\n"
+                 "             [--phase=index,validate,lex,parse,dom,serialize,encode,decode] [--iterations=5] [--seed=42]\n"
+                 "             [--format=text|json|csv]\n";
+}
+
+auto parse_options(int argc, char** argv) -> std::optional<Options> {
+    Options options;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view argument = argv[i];
+        const auto equals = argument.find('=');
+        const auto name = argument.substr(0, equals);
+        const auto value = equals == std::string_view::npos ? std::string_view{} : argument.substr(equals + 1);
+
+        if (name == "--corpus") {
+            options.corpora.clear();
+
+            for (const auto item : split_list(value)) {
+                const auto kind = corpus_kind_from_string(item);
+
+                if (not kind)
+                    return std::nullopt;
+
+                options.corpora.push_back(*kind);
+            }
+        } else if (name == "--size") {
+            options.sizes.clear();
+
+            for (const auto item : split_list(value)) {
+                const auto size = parse_size(item);
+
+                if (not size)
+                    return std::nullopt;
+
+                options.sizes.push_back(*size);
+            }
+        } else if (name == "--phase") {
+            options.phases.clear();
+
+            for (const auto item : split_list(value)) {
+                const auto phase = std::find_if(std::begin(all_phases), std::end(all_phases), [item](Phase phase) {
+                        return phase_to_string(phase) == item;
+                        });
+
+                if (phase == std::end(all_phases))
+                    return std::nullopt;
+
+                options.phases.push_back(*phase);
+            }
+        } else if (name == "--iterations") {
+            const auto iterations = parse_size(value);
+
+            if (not iterations or *iterations == 0)
+                return std::nullopt;
+
+            options.iterations = *iterations;
+        } else if (name == "--seed") {
+            const auto seed = parse_size(value);
+
+            if (not seed)
+                return std::nullopt;
+
+            options.seed = *seed;
+        } else if (name == "--format") {
+            if (value == "text")
+                options.format = Format::Text;
+            else if (value == "json")
+                options.format = Format::Json;
+            else if (value == "csv")
+                options.format = Format::Csv;
+            else
+                return std::nullopt;
+        } else {
+            return std::nullopt;
+        }
+    }
+
+    return options;
+}
+
+}
+
+auto main(int argc, char** argv) -> int {
+    const auto options = parse_options(argc, argv);
+
+    if (not options) {
+        print_usage();
+        return 1;
+    }
+
+    if (options->format == Format::Text)
+        std::cout << "simd: " << simd_level_to_string(detect_simd_level()) << '\n';
+
+    if (options->format == Format::Csv)
+        std::cout << "corpus,bytes,documents,phase,iterations,seconds,mb_per_second,documents_per_second,"
+                     "allocations_per_document,allocated_bytes_per_document,peak_rss_kib\n";
+
+    for (const auto kind : options->corpora) {
+        for (const auto size : options->sizes) {
+            const auto corpus = generate_corpus(kind, size, options->seed);
+
+            for (const auto phase : options->phases)
+                report(measure(corpus, phase, *options), options->format);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,236 @@
+#include <array>
+
+#include "corpus.h"
+
+namespace {
+
+// splitmix64, small and identical on every platform, unlike the
+// distributions in <random>.
+class Random {
+public:
+    Random(std::uint64_t seed)
+        : m_state(seed) {}
+
+    auto next() -> std::uint64_t {
+        auto z = (m_state += 0x9e3779b97f4a7c15ull);
+
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+        return z ^ (z >> 31);
+    }
+
+    auto below(std::uint64_t bound) -> std::uint64_t {
+        return next() % bound;
+    }
+
+private:
+    std::uint64_t m_state;
+};
+
+constexpr std::size_t deep_depth = 64;
+
+auto append_word(std::string& out, Random& random, std::size_t length) -> void {
+    for (std::size_t i = 0; i < length; i++)
+        out.push_back(static_cast<char>('a' + random.below(26)));
+}
+
+auto append_integer(std::string& out, Random& random) -> void {
+    // mostly small values, with the occasional full width one.
+    if (random.below(8) == 0)
+        out.append(std::to_string(static_cast<std::int64_t>(random.next())));
+    else
+        out.append(std::to_string(random.below(100000)));
+}
+
+auto append_double(std::string& out, Random& random) -> void {
+    const auto mantissa = random.below(1000000000);
+    const auto exponent = static_cast<int>(random.below(40)) - 20;
+
+    if (random.below(2) == 0)
+        out.push_back('-');
+
+    out.append(std::to_string(mantissa / 1000));
+    out.push_back('.');
+    out.append(std::to_string(mantissa % 1000));
+
+    if (exponent < -10 or exponent > 10) {
+        out.push_back('e');
+        out.append(std::to_string(exponent));
+    }
+}
+
+auto append_text(std::string& out, Random& random) -> void {
+    static constexpr std::array<std::string_view, 6> specials = {
+        "\\\"", "\\\\", "\\n", "\\t", "\\u00e9", "\xc3\xa9",
+    };
+
+    out.push_back('"');
+
+    const auto words = 4 + random.below(24);
+
+    for (std::uint64_t i = 0; i < words; i++) {
+        if (i != 0)
+            out.push_back(' ');
+
+        if (random.below(6) == 0)
+            out.append(specials[random.below(specials.size())]);
+
+        append_word(out, random, 2 + random.below(9));
+    }
+
+    out.push_back('"');
+}
+
+auto append_nested(std::string& out, Random& random, std::size_t depth) -> void {
+    if (depth == 0) {
+        append_integer(out, random);
+        return;
+    }
+
+    if (depth % 2 == 0) {
+        out.append("{\"level\":");
+        out.append(std::to_string(depth));
+        out.append(",\"next\":");
+        append_nested(out, random, depth - 1);
+        out.push_back('}');
+    } else {
+        out.append("[true,");
+        append_nested(out, random, depth - 1);
+        out.append(",null]");
+    }
+}
+
+auto append_record(std::string& out, Random& random, std::size_t id) -> void {
+    out.append("{\"id\":");
+    out.append(std::to_string(id));
+    out.append(",\"user\":\"");
+    append_word(out, random, 4 + random.below(8));
+    out.append("\",\"score\":");
+    append_double(out, random);
+    out.append(",\"active\":");
+    out.append(random.below(2) == 0 ? "true" : "false");
+    out.append(",\"tags\":[");
+
+    const auto tags = random.below(5);
+
+    for (std::uint64_t i = 0; i < tags; i++) {
+        if (i != 0)
+            out.push_back(',');
+
+        out.push_back('"');
+        append_word(out, random, 3 + random.below(5));
+        out.push_back('"');
+    }
+
+    out.append("],\"message\":");
+    append_text(out, random);
+    out.push_back('}');
+}
+
+// fills out with comma separated items until it is past target_bytes.
+template <typename Func>
+auto append_items(std::string& out, std::size_t target_bytes, Func append_item) -> void {
+    for (std::size_t i = 0; i == 0 or out.length() < target_bytes; i++) {
+        if (i != 0)
+            out.push_back(',');
+
+        append_item(i);
+    }
+}
+
+}
+
+auto corpus_kind_to_string(CorpusKind kind) -> std::string_view {
+    switch (kind) {
+    case CorpusKind::Deep:
+        return "deep";
+    case CorpusKind::Wide:
+        return "wide";
+    case CorpusKind::Numeric:
+        return "numeric";
+    case CorpusKind::Strings:
+        return "strings";
+    case CorpusKind::Ndjson:
+        return "ndjson";
+    }
+
+    return "unknown";
+}
+
+auto corpus_kind_from_string(std::string_view name) -> std::optional<CorpusKind> {
+    for (const auto kind : {CorpusKind::Deep, CorpusKind::Wide, CorpusKind::Numeric, CorpusKind::Strings, CorpusKind::Ndjson}) {
+        if (corpus_kind_to_string(kind) == name)
+            return kind;
+    }
+
+    return std::nullopt;
+}
+
+auto generate_corpus(CorpusKind kind, std::size_t target_bytes, std::uint64_t seed) -> Corpus {
+    Random random(seed);
+    Corpus corpus{kind, {}, 1};
+
+    auto& out = corpus.text;
+
+    out.reserve(target_bytes + 4096);
+
+    switch (kind) {
+    case CorpusKind::Deep:
+        out.append("{\"items\":[");
+        append_items(out, target_bytes, [&](std::size_t) { append_nested(out, random, deep_depth); });
+        out.append("]}");
+        break;
+    case CorpusKind::Wide:
+        out.push_back('{');
+        append_items(out, target_bytes, [&](std::size_t i) {
+                out.append("\"key_");
+                out.append(std::to_string(i));
+                out.append("\":");
+
+                switch (random.below(4)) {
+                case 0:
+                    append_integer(out, random);
+                    break;
+                case 1:
+                    append_double(out, random);
+                    break;
+                case 2:
+                    out.push_back('"');
+                    append_word(out, random, 4 + random.below(12));
+                    out.push_back('"');
+                    break;
+                default:
+                    out.append(random.below(2) == 0 ? "false" : "null");
+                    break;
+                }
+                });
+        out.push_back('}');
+        break;
+    case CorpusKind::Numeric:
+        out.append("{\"values\":[");
+        append_items(out, target_bytes, [&](std::size_t) {
+                if (random.below(2) == 0)
+                    append_integer(out, random);
+                else
+                    append_double(out, random);
+                });
+        out.append("]}");
+        break;
+    case CorpusKind::Strings:
+        out.append("{\"strings\":[");
+        append_items(out, target_bytes, [&](std::size_t) { append_text(out, random); });
+        out.append("]}");
+        break;
+    case CorpusKind::Ndjson:
+        corpus.documents = 0;
+
+        while (corpus.documents == 0 or out.length() < target_bytes) {
+            append_record(out, random, corpus.documents++);
+            out.push_back('\n');
+        }
+        break;
+    }
+
+    return corpus;
+}
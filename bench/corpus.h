@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+enum class CorpusKind {
+    // many subtrees nested 64 levels deep, alternating objects and arrays.
+    Deep,
+    // a single object with one member per value.
+    Wide,
+    // a long array of integers and doubles of every magnitude.
+    Numeric,
+    // a long array of text with escape sequences and multi byte utf-8.
+    Strings,
+    // newline delimited records of a typical event shape.
+    Ndjson,
+};
+
+auto corpus_kind_to_string(CorpusKind kind) -> std::string_view;
+
+auto corpus_kind_from_string(std::string_view name) -> std::optional<CorpusKind>;
+
+struct Corpus {
+    CorpusKind kind;
+    std::string text;
+
+    // one for a single document, the number of records for ndjson.
+    std::size_t documents;
+};
+
+// The same kind, size and seed always produce the same bytes, so runs on
+// different machines or commits measure exactly the same input. The text
+// stops at the first document boundary past target_bytes.
+auto generate_corpus(CorpusKind kind, std::size_t target_bytes, std::uint64_t seed = 42) -> Corpus;
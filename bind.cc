@@ -0,0 +1,179 @@
+#include "bind.h"
+#include "escape.h"
+
+namespace json_bind {
+
+auto Reader::finish() -> bool {
+    if (expect(TokenType::EndOfFile))
+        return true;
+
+    error_unexpected_token();
+
+    return false;
+}
+
+auto Reader::read_bool(bool& value) -> bool {
+    if (not expect(TokenType::BooleanTrue) and not expect(TokenType::BooleanFalse)) {
+        error_unexpected_token();
+        return false;
+    }
+
+    value = expect(TokenType::BooleanTrue);
+
+    advance();
+
+    return true;
+}
+
+auto Reader::read_number(NumberValue& value) -> bool {
+    if (not expect(TokenType::NumberLiteral)) {
+        error_unexpected_token();
+        return false;
+    }
+
+    const auto number = parse_number_value(m_current.lexeme());
+
+    if (not number) {
+        error_at(JsonErrorCode::NumberOutOfRange, m_lexer.token_offset(), m_current.lexeme());
+        return false;
+    }
+
+    value = *number;
+
+    advance();
+
+    return true;
+}
+
+auto Reader::read_double(double& value) -> bool {
+    NumberValue number;
+
+    if (not read_number(number))
+        return false;
+
+    value = std::visit([](auto number) { return static_cast<double>(number); }, number);
+
+    return true;
+}
+
+auto Reader::read_string(std::string& value) -> bool {
+    if (not expect(TokenType::StringLiteral)) {
+        error_unexpected_token();
+        return false;
+    }
+
+    if (m_current.is_escaped()) {
+        value.clear();
+        unescape_string(m_current.lexeme(), value);
+    } else {
+        value.assign(m_current.lexeme());
+    }
+
+    advance();
+
+    return true;
+}
+
+// steps over one value of any kind, nothing is built but the grammar is
+// checked all the same, so a skipped member cannot hide malformed input.
+// nesting is kept on a stack rather than by recursion.
+auto Reader::skip_value() -> bool {
+    // one entry per open container, true for objects.
+    std::vector<bool> stack;
+
+    const auto skip_key = [this] {
+        if (not expect(TokenType::StringLiteral)) {
+            error_unexpected_token();
+            return false;
+        }
+
+        advance();
+
+        return eat_token(TokenType::Colon);
+    };
+
+    while (true) {
+        switch (m_current.type()) {
+        case TokenType::OpenCurlyBrace:
+        case TokenType::OpenBrace: {
+            const auto is_object = expect(TokenType::OpenCurlyBrace);
+
+            advance();
+
+            if (expect(is_object ? TokenType::CloseCurlyBrace : TokenType::CloseBrace)) {
+                advance();
+                break;
+            }
+
+            stack.push_back(is_object);
+
+            if (is_object and not skip_key())
+                return false;
+
+            continue;
+        }
+        case TokenType::StringLiteral:
+        case TokenType::NumberLiteral:
+        case TokenType::BooleanTrue:
+        case TokenType::BooleanFalse:
+        case TokenType::Null:
+            advance();
+            break;
+        default:
+            error_unexpected_token();
+            return false;
+        }
+
+        // a value is complete, close whatever ends with it.
+        while (true) {
+            if (stack.empty())
+                return true;
+
+            if (expect(TokenType::Comma)) {
+                advance();
+
+                if (stack.back() and not skip_key())
+                    return false;
+
+                break;
+            }
+
+            if (not eat_token(stack.back() ? TokenType::CloseCurlyBrace : TokenType::CloseBrace))
+                return false;
+
+            stack.pop_back();
+        }
+    }
+}
+
+auto Reader::advance() -> void {
+    if (m_current.type() == TokenType::EndOfFile)
+        return;
+
+    m_current = m_lexer.get_token();
+}
+
+auto Reader::expect(TokenType type) -> bool {
+    return m_current.type() == type;
+}
+
+auto Reader::eat_token(TokenType type) -> bool {
+    if (not expect(type)) {
+        m_error = JsonError::expected_token(type, m_current.type(), m_lexer.token_offset());
+        return false;
+    }
+
+    advance();
+
+    return true;
+}
+
+auto Reader::error_unexpected_token() -> void {
+    m_error = JsonError::unexpected_token(m_current.type(), m_lexer.token_offset());
+}
+
+auto Reader::error_at(JsonErrorCode code, std::size_t offset, std::string_view context) -> void {
+    m_error = JsonError(code, offset, context);
+}
+
+}
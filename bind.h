@@ -0,0 +1,454 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "lexer.h"
+#include "number.h"
+#include "parser.h"
+#include "writer.h"
+
+// Binding between a json object and a plain struct. A struct opts in by
+// specializing JsonBinding with a constexpr table of its fields:
+//
+//   template <>
+//   struct JsonBinding<Player> {
+//       static constexpr auto fields = std::make_tuple(
+//               json_field("name", &Player::name),
+//               json_field("health", &Player::health));
+//   };
+//
+// Members can be bool, integers, floating point numbers, std::string,
+// std::optional and std::vector of those, or other bound structs. Optional
+// members may be missing or null, every other member is required.
+template <typename Class, typename Member>
+struct JsonField {
+    using class_type = Class;
+    using member_type = Member;
+
+    std::string_view name;
+    Member Class::* member;
+};
+
+template <typename Class, typename Member>
+constexpr auto json_field(std::string_view name, Member Class::* member) -> JsonField<Class, Member> {
+    return JsonField<Class, Member>{name, member};
+}
+
+template <typename T>
+struct JsonBinding;
+
+template <typename T>
+concept JsonBound = requires { JsonBinding<T>::fields; };
+
+struct JsonBindOptions {
+    // skip members the struct does not declare instead of failing.
+    bool allow_unknown_fields{false};
+};
+
+namespace json_bind {
+
+template <typename T>
+struct is_optional : std::false_type {};
+
+template <typename T>
+struct is_optional<std::optional<T>> : std::true_type {};
+
+template <typename T>
+struct is_vector : std::false_type {};
+
+template <typename T, typename Allocator>
+struct is_vector<std::vector<T, Allocator>> : std::true_type {};
+
+template <typename T>
+constexpr auto field_count = std::tuple_size_v<std::remove_cvref_t<decltype(JsonBinding<T>::fields)>>;
+
+template <typename T, std::size_t I>
+using field_type = typename std::remove_cvref_t<decltype(std::get<I>(JsonBinding<T>::fields))>::member_type;
+
+constexpr auto hash_name(std::string_view name, std::uint64_t seed) -> std::uint64_t {
+    // FNV-1a, seeded so the compile-time search can try another function.
+    auto hash = 0xcbf29ce484222325ull ^ seed;
+
+    for (const auto c : name) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash ^ (hash >> 32);
+}
+
+// Collision free hash table over the field names of T, found at compile
+// time by trying seeds until every name lands in its own slot. A lookup is
+// one hash, one slot and one string compare.
+template <typename T>
+class PerfectHash {
+public:
+    static constexpr auto count = field_count<T>;
+    static constexpr auto capacity = std::bit_ceil(std::max<std::size_t>(count * 8, 1));
+
+    consteval PerfectHash() {
+        const auto names = field_names();
+
+        // the smallest table that works keeps the lookup in fewer cache lines.
+        for (auto size = std::bit_ceil(std::max<std::size_t>(count * 2, 1)); size <= capacity; size *= 2) {
+            for (std::uint64_t seed = 0; seed < 4096; seed++) {
+                if (try_build(names, seed, size))
+                    return;
+            }
+        }
+
+        throw "no perfect hash for the field names, are two of them equal?";
+    }
+
+    // index of the field, count if there is none with that name.
+    constexpr auto find(std::string_view name) const -> std::size_t {
+        const auto slot = m_slots[hash_name(name, m_seed) & m_mask];
+
+        if (slot == 0 or m_names[slot - 1] != name)
+            return count;
+
+        return slot - 1;
+    }
+
+    static constexpr auto field_names() -> std::array<std::string_view, count> {
+        return [] <std::size_t... I> (std::index_sequence<I...>) {
+            return std::array<std::string_view, count>{std::get<I>(JsonBinding<T>::fields).name...};
+        }(std::make_index_sequence<count>{});
+    }
+
+private:
+    constexpr auto try_build(const std::array<std::string_view, count>& names, std::uint64_t seed, std::size_t size) -> bool {
+        std::array<std::uint16_t, capacity> slots{};
+
+        for (std::size_t i = 0; i < count; i++) {
+            auto& slot = slots[hash_name(names[i], seed) & (size - 1)];
+
+            if (slot != 0)
+                return false;
+
+            slot = static_cast<std::uint16_t>(i + 1);
+        }
+
+        m_names = names;
+        m_slots = slots;
+        m_seed = seed;
+        m_mask = size - 1;
+
+        return true;
+    }
+
+private:
+    std::array<std::string_view, count> m_names{};
+
+    // field index + 1 per slot, 0 marks an empty slot.
+    std::array<std::uint16_t, capacity> m_slots{};
+    std::uint64_t m_seed{0};
+    std::size_t m_mask{0};
+};
+
+// Fills bound structs straight from the lexer's tokens, no JsonValue is
+// built on the way.
+class Reader {
+public:
+    Reader(std::string_view input, const StructuralIndex& index, JsonBindOptions options)
+        : m_lexer(input, index), m_current(m_lexer.get_token()), m_options(options) {}
+
+    template <typename T>
+    auto read(T& value) -> bool {
+        if constexpr (std::is_same_v<T, bool>) {
+            return read_bool(value);
+        } else if constexpr (std::is_integral_v<T>) {
+            return read_integer(value);
+        } else if constexpr (std::is_floating_point_v<T>) {
+            double number = 0;
+
+            if (not read_double(number))
+                return false;
+
+            value = static_cast<T>(number);
+
+            return true;
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            return read_string(value);
+        } else if constexpr (is_optional<T>::value) {
+            if (expect(TokenType::Null)) {
+                value.reset();
+                advance();
+                return true;
+            }
+
+            return read(value.emplace());
+        } else if constexpr (is_vector<T>::value) {
+            return read_array(value);
+        } else {
+            static_assert(JsonBound<T>, "type has no JsonBinding");
+
+            return read_object(value);
+        }
+    }
+
+    // the whole input has to be consumed.
+    auto finish() -> bool;
+
+    // only meaningful once read or finish failed.
+    auto error() const -> const JsonError& { return *m_error; }
+
+private:
+    template <typename T>
+    auto read_integer(T& value) -> bool {
+        const auto literal = m_current.lexeme();
+        const auto offset = m_lexer.token_offset();
+
+        NumberValue number;
+
+        if (not read_number(number))
+            return false;
+
+        // without a fraction or exponent a double is -0 or past 64 bits.
+        const auto is_integer = literal.find_first_of(".eE") == std::string_view::npos;
+
+        const auto fits = std::visit([&value, is_integer](auto integer) {
+                if constexpr (std::is_integral_v<decltype(integer)>) {
+                    if (std::in_range<T>(integer)) {
+                        value = static_cast<T>(integer);
+                        return true;
+                    }
+                } else if (is_integer and integer == 0) {
+                    value = 0;
+                    return true;
+                }
+
+                return false;
+                }, number);
+
+        if (not fits)
+            error_at(is_integer ? JsonErrorCode::IntegerOutOfRange : JsonErrorCode::NotAnInteger, offset, literal);
+
+        return fits;
+    }
+
+    template <typename T>
+    auto read_array(std::vector<T>& elements) -> bool {
+        if (not eat_token(TokenType::OpenBrace))
+            return false;
+
+        elements.clear();
+
+        if (expect(TokenType::CloseBrace)) {
+            advance();
+            return true;
+        }
+
+        while (true) {
+            if (not read(elements.emplace_back()))
+                return false;
+
+            if (not expect(TokenType::Comma))
+                return eat_token(TokenType::CloseBrace);
+
+            advance();
+        }
+    }
+
+    template <typename T>
+    auto read_object(T& object) -> bool {
+        static constexpr auto count = field_count<T>;
+        static constexpr PerfectHash<T> hash;
+
+        // one reader per field, picked by the index the hash hands out.
+        static constexpr auto readers = [] <std::size_t... I> (std::index_sequence<I...>) {
+            return std::array<bool (*)(Reader&, T&), count>{&Reader::read_field<T, I>...};
+        }(std::make_index_sequence<count>{});
+
+        static constexpr auto required = [] <std::size_t... I> (std::index_sequence<I...>) {
+            return std::array<bool, count>{not is_optional<field_type<T, I>>::value...};
+        }(std::make_index_sequence<count>{});
+
+        std::array<bool, count> seen{};
+
+        const auto start = m_lexer.token_offset();
+
+        if (not eat_token(TokenType::OpenCurlyBrace))
+            return false;
+
+        if (expect(TokenType::CloseCurlyBrace)) {
+            advance();
+        } else {
+            while (true) {
+                if (not expect(TokenType::StringLiteral)) {
+                    error_unexpected_token();
+                    return false;
+                }
+
+                const auto key = m_current.text(m_scratch);
+                const auto key_offset = m_lexer.token_offset();
+
+                advance();
+
+                if (not eat_token(TokenType::Colon))
+                    return false;
+
+                if (const auto field = hash.find(key); field != count) {
+                    if (not readers[field](*this, object))
+                        return false;
+
+                    seen[field] = true;
+                } else if (not m_options.allow_unknown_fields) {
+                    error_at(JsonErrorCode::UnknownField, key_offset, key);
+                    return false;
+                } else if (not skip_value()) {
+                    return false;
+                }
+
+                if (not expect(TokenType::Comma))
+                    break;
+
+                advance();
+            }
+
+            if (not eat_token(TokenType::CloseCurlyBrace))
+                return false;
+        }
+
+        for (std::size_t i = 0; i < count; i++) {
+            if (required[i] and not seen[i]) {
+                error_at(JsonErrorCode::MissingField, start, PerfectHash<T>::field_names()[i]);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    template <typename T, std::size_t I>
+    static auto read_field(Reader& reader, T& object) -> bool {
+        return reader.read(object.*(std::get<I>(JsonBinding<T>::fields).member));
+    }
+
+    auto read_bool(bool& value) -> bool;
+
+    auto read_number(NumberValue& value) -> bool;
+
+    auto read_double(double& value) -> bool;
+
+    auto read_string(std::string& value) -> bool;
+
+    auto skip_value() -> bool;
+
+    auto advance() -> void;
+
+    auto expect(TokenType type) -> bool;
+
+    auto eat_token(TokenType type) -> bool;
+
+    auto error_unexpected_token() -> void;
+
+    auto error_at(JsonErrorCode code, std::size_t offset, std::string_view context = {}) -> void;
+
+private:
+    JsonLexer m_lexer;
+    Token m_current;
+    JsonBindOptions m_options;
+    std::optional<JsonError> m_error;
+
+    // keys with escape sequences, decoded.
+    std::string m_scratch;
+};
+
+template <typename T>
+auto write_value(JsonWriter& writer, const T& value) -> void {
+    if constexpr (std::is_same_v<T, bool>) {
+        writer.write_bool(value);
+    } else if constexpr (std::is_integral_v<T> and std::is_signed_v<T>) {
+        writer.write_int64(value);
+    } else if constexpr (std::is_integral_v<T>) {
+        writer.write_uint64(value);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        writer.write_number(value);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        writer.write_string(value);
+    } else if constexpr (is_optional<T>::value) {
+        if (value)
+            write_value(writer, *value);
+        else
+            writer.write_null();
+    } else if constexpr (is_vector<T>::value) {
+        writer.start_array();
+
+        for (const auto& element : value)
+            write_value(writer, element);
+
+        writer.end_array();
+    } else {
+        static_assert(JsonBound<T>, "type has no JsonBinding");
+
+        writer.start_object();
+
+        std::apply([&](const auto&... fields) {
+                const auto write_member = [&](const auto& field) {
+                    const auto& member = value.*(field.member);
+
+                    // an empty optional is left out, it reads back the same.
+                    if constexpr (is_optional<std::remove_cvref_t<decltype(member)>>::value) {
+                        if (not member)
+                            return;
+                    }
+
+                    writer.write_key(field.name);
+                    write_value(writer, member);
+                };
+
+                (write_member(fields), ...);
+                }, JsonBinding<T>::fields);
+
+        writer.end_object();
+    }
+}
+
+}
+
+// Parses straight into T and writes T back out. Key lookups go through a
+// perfect hash built at compile time from the field table.
+template <JsonBound T>
+class JsonBinder {
+public:
+    static auto parse(std::string_view input, const JsonBindOptions& options = {}) -> ErrorOr<T> {
+        if (input.length() > StructuralIndex::max_input_size)
+            return JsonError(JsonErrorCode::InputTooLarge, 0);
+
+        const auto index = StructuralIndex::build(input);
+
+        json_bind::Reader reader(input, index, options);
+
+        T result{};
+
+        if (not reader.read(result) or not reader.finish())
+            return reader.error();
+
+        return result;
+    }
+
+    static auto write(JsonWriter& writer, const T& value) -> void {
+        json_bind::write_value(writer, value);
+    }
+
+    static auto serialize(const T& value, const JsonWriterOptions& options = {}) -> std::string {
+        JsonWriter writer(options);
+
+        write(writer, value);
+
+        return writer.take();
+    }
+};
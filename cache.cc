@@ -0,0 +1,171 @@
+#include <optional>
+#include <random>
+
+#include "cache.h"
+#include "hash.h"
+
+namespace {
+
+// strings up to this length live inside std::string itself.
+constexpr std::size_t inline_string_length = 15;
+
+// make_shared puts the reference counts next to the value.
+constexpr std::size_t control_block_size = 16;
+
+auto heap_string_size(std::string_view string) -> std::size_t {
+    return string.length() > inline_string_length ? string.length() + 1 : 0;
+}
+
+// roughly what the tree holds on the heap, close enough to budget by.
+auto approximate_size(const JsonValue& value) -> std::size_t {
+    switch (value.get_type()) {
+    case JsonValueType::JsonBool:
+        return control_block_size + sizeof(JsonBool);
+    case JsonValueType::JsonNumber:
+        return control_block_size + sizeof(JsonNumber);
+    case JsonValueType::JsonString:
+        return control_block_size + sizeof(JsonString) + heap_string_size(static_cast<const JsonString&>(value).view());
+    case JsonValueType::JsonObject: {
+        auto size = control_block_size + sizeof(JsonObject);
+
+        static_cast<const JsonObject&>(value).access([&size](const JsonObjectDict& dict) {
+                if (dict.size() > JsonObjectDict::inline_capacity)
+                    size += dict.size() * sizeof(JsonObjectDict::value_type);
+
+                for (const auto& [key, member] : dict) {
+                    if (not key.is_interned())
+                        size += heap_string_size(key.view());
+
+                    size += approximate_size(*member);
+                }
+                });
+
+        return size;
+    }
+    case JsonValueType::JsonArray: {
+        auto size = control_block_size + sizeof(JsonArray);
+
+        static_cast<const JsonArray&>(value).access([&size](const JsonArrayElements& elements) {
+                size += elements.capacity() * sizeof(JsonArrayElements::value_type);
+
+                for (const auto& elem : elements)
+                    size += approximate_size(*elem);
+                });
+
+        return size;
+    }
+    case JsonValueType::JsonNull:
+        break;
+    }
+
+    return control_block_size + sizeof(JsonNull);
+}
+
+}
+
+JsonDocumentCache::JsonDocumentCache(JsonDocumentCacheOptions options)
+    : m_options(options)
+{
+    std::random_device random;
+
+    m_seed = (static_cast<std::uint64_t>(random()) << 32) | random();
+}
+
+auto JsonDocumentCache::parse(std::string_view input) -> ErrorOr<JsonDocument> {
+    const auto key = Key{hash_bytes(input, m_seed), input.length()};
+
+    std::shared_ptr<const std::string> cached_input;
+    std::optional<JsonDocument> cached;
+
+    {
+        std::lock_guard lock(m_mutex);
+
+        // counted as a hit and moved to the front before the inputs are
+        // compared, a collision is rare enough to fix up afterwards.
+        if (const auto found = m_index.find(key); found != m_index.end()) {
+            m_entries.splice(m_entries.begin(), m_entries, found->second);
+            m_stats.hits++;
+
+            cached_input = found->second->input;
+            cached = found->second->document;
+        } else {
+            m_stats.misses++;
+        }
+    }
+
+    // the compare is as long as the input, it runs without the lock.
+    if (cached) {
+        if (*cached_input == input)
+            return std::move(*cached);
+
+        // a different input with the same hash is a miss, it is parsed but
+        // not cached.
+        std::lock_guard lock(m_mutex);
+
+        m_stats.hits--;
+        m_stats.misses++;
+    }
+
+    auto parsed = TRY(JsonParser::parse(input, m_options.parser));
+    const auto bytes = approximate_size(parsed) + input.length();
+    auto document = JsonDocument(std::move(parsed));
+
+    if (bytes > m_options.max_bytes)
+        return document;
+
+    return insert(key, input, std::move(document), bytes);
+}
+
+auto JsonDocumentCache::stats() const -> JsonDocumentCacheStats {
+    std::lock_guard lock(m_mutex);
+
+    return m_stats;
+}
+
+auto JsonDocumentCache::clear() -> void {
+    std::lock_guard lock(m_mutex);
+
+    m_entries.clear();
+    m_index.clear();
+
+    m_stats.entries = 0;
+    m_stats.bytes = 0;
+}
+
+auto JsonDocumentCache::insert(const Key& key, std::string_view input, JsonDocument document, std::size_t bytes) -> JsonDocument {
+    // copied before taking the lock, and compared after letting go of it.
+    auto kept_input = std::make_shared<const std::string>(input);
+
+    std::unique_lock lock(m_mutex);
+
+    // someone else parsed the same input in the meantime, theirs is kept so
+    // every caller shares one tree. a colliding input keeps the slot as is.
+    if (const auto found = m_index.find(key); found != m_index.end()) {
+        const auto other_input = found->second->input;
+        auto other = found->second->document;
+
+        lock.unlock();
+
+        return *other_input == input ? other : document;
+    }
+
+    while (m_stats.bytes + bytes > m_options.max_bytes) {
+        const auto& oldest = m_entries.back();
+
+        m_stats.evictions++;
+        m_stats.evicted_bytes += oldest.bytes;
+        m_stats.bytes -= oldest.bytes;
+        m_stats.entries--;
+
+        m_index.erase(oldest.key);
+        m_entries.pop_back();
+    }
+
+    m_entries.push_front(Entry{key, std::move(kept_input), document, bytes});
+    m_index.emplace(key, m_entries.begin());
+
+    m_stats.entries++;
+    m_stats.bytes += bytes;
+
+    return document;
+}
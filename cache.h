@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "document.h"
+#include "parser.h"
+
+struct JsonDocumentCacheOptions {
+    // upper bound on the approximate memory held by cached documents, the
+    // least recently used ones are dropped to stay under it. a document
+    // larger than the whole budget is parsed but never cached.
+    std::size_t max_bytes{64 << 20};
+
+    // used for every parse the cache does.
+    JsonParserOptions parser;
+};
+
+struct JsonDocumentCacheStats {
+    std::uint64_t hits{0};
+    std::uint64_t misses{0};
+    std::uint64_t evictions{0};
+    std::uint64_t evicted_bytes{0};
+
+    std::size_t entries{0};
+    std::size_t bytes{0};
+};
+
+// Opt-in cache in front of JsonParser::parse for inputs that arrive over
+// and over again byte for byte. Documents are looked up by a 64-bit hash of
+// the input, seeded at random per cache so collisions cannot be planned,
+// and a hit compares the input with the one kept in the entry, so a
+// repeated payload costs a hash, a lookup and a compare instead of a parse.
+// Every entry keeps a copy of its input next to the tree, so the input is
+// held twice, once parsed and once as text, and both count against
+// max_bytes.
+//
+// Documents are handed out as JsonDocument, which only allows reading, so
+// every caller can share the same tree. Evicting one only drops the
+// cache's reference. Safe to use from any number of threads, the lock is
+// never held while parsing or comparing inputs; concurrent misses on the
+// same input both parse and the first one to finish is kept. Errors are
+// not cached.
+class JsonDocumentCache {
+public:
+    JsonDocumentCache(JsonDocumentCacheOptions options = {});
+
+    JsonDocumentCache(const JsonDocumentCache& other) = delete;
+
+    auto operator=(const JsonDocumentCache& other) -> JsonDocumentCache& = delete;
+
+    auto parse(std::string_view input) -> ErrorOr<JsonDocument>;
+
+    auto stats() const -> JsonDocumentCacheStats;
+
+    auto clear() -> void;
+
+private:
+    struct Key {
+        std::uint64_t hash;
+        std::size_t length;
+
+        auto operator==(const Key& other) const -> bool = default;
+    };
+
+    struct KeyHash {
+        auto operator()(const Key& key) const -> std::size_t {
+            return static_cast<std::size_t>(key.hash);
+        }
+    };
+
+    struct Entry {
+        Key key;
+        // shared so a hit can compare against it without holding the lock.
+        std::shared_ptr<const std::string> input;
+        JsonDocument document;
+        std::size_t bytes;
+    };
+
+    // front is the most recently used.
+    using Entries = std::list<Entry>;
+
+    auto insert(const Key& key, std::string_view input, JsonDocument document, std::size_t bytes) -> JsonDocument;
+
+private:
+    JsonDocumentCacheOptions m_options;
+    std::uint64_t m_seed;
+
+    mutable std::mutex m_mutex;
+    Entries m_entries;
+    std::unordered_map<Key, Entries::iterator, KeyHash> m_index;
+
+    JsonDocumentCacheStats m_stats;
+};
@@ -0,0 +1,347 @@
+#include <bit>
+#include <cmath>
+#include <limits>
+
+#include "cbor.h"
+#include "escape.h"
+
+namespace {
+
+enum class MajorType : std::uint8_t {
+    UnsignedInteger = 0,
+    NegativeInteger = 1,
+    ByteString = 2,
+    TextString = 3,
+    Array = 4,
+    Map = 5,
+    Tag = 6,
+    Simple = 7,
+};
+
+constexpr std::uint8_t simple_false = 0xf4;
+constexpr std::uint8_t simple_true = 0xf5;
+constexpr std::uint8_t simple_null = 0xf6;
+constexpr std::uint8_t float32_head = 0xfa;
+constexpr std::uint8_t float64_head = 0xfb;
+
+// additional information values of the initial byte.
+constexpr std::uint8_t one_byte_argument = 24;
+constexpr std::uint8_t indefinite_length = 31;
+
+auto append_big_endian(std::string& out, std::uint64_t value, std::size_t bytes) -> void {
+    for (auto shift = bytes * 8; shift != 0; shift -= 8)
+        out.push_back(static_cast<char>(value >> (shift - 8)));
+}
+
+// the initial byte and the argument in the shortest form that holds it.
+auto append_head(std::string& out, MajorType major, std::uint64_t argument) -> void {
+    const auto type = static_cast<std::uint8_t>(static_cast<std::uint8_t>(major) << 5);
+
+    if (argument < one_byte_argument) {
+        out.push_back(static_cast<char>(type | argument));
+    } else if (argument <= 0xff) {
+        out.push_back(static_cast<char>(type | 24));
+        append_big_endian(out, argument, 1);
+    } else if (argument <= 0xffff) {
+        out.push_back(static_cast<char>(type | 25));
+        append_big_endian(out, argument, 2);
+    } else if (argument <= 0xffffffff) {
+        out.push_back(static_cast<char>(type | 26));
+        append_big_endian(out, argument, 4);
+    } else {
+        out.push_back(static_cast<char>(type | 27));
+        append_big_endian(out, argument, 8);
+    }
+}
+
+auto append_int64(std::string& out, std::int64_t number) -> void {
+    if (number >= 0)
+        append_head(out, MajorType::UnsignedInteger, static_cast<std::uint64_t>(number));
+    else
+        append_head(out, MajorType::NegativeInteger, ~static_cast<std::uint64_t>(number));
+}
+
+auto append_double(std::string& out, double number) -> void {
+    // anything that survives the trip through a float is written as one,
+    // the value read back is the same double.
+    if (std::fabs(number) <= std::numeric_limits<float>::max()) {
+        const auto single = static_cast<float>(number);
+
+        if (static_cast<double>(single) == number) {
+            out.push_back(static_cast<char>(float32_head));
+            append_big_endian(out, std::bit_cast<std::uint32_t>(single), 4);
+            return;
+        }
+    }
+
+    out.push_back(static_cast<char>(float64_head));
+    append_big_endian(out, std::bit_cast<std::uint64_t>(number), 8);
+}
+
+auto append_text(std::string& out, std::string_view text) -> void {
+    append_head(out, MajorType::TextString, text.length());
+    out.append(text);
+}
+
+auto append_value(std::string& out, const JsonValue& value) -> void {
+    switch (value.get_type()) {
+    case JsonValueType::JsonBool:
+        static_cast<const JsonBool&>(value).access([&out](const bool& boolean) {
+                out.push_back(static_cast<char>(boolean ? simple_true : simple_false));
+                });
+        break;
+    case JsonValueType::JsonNumber: {
+        const auto& number = static_cast<const JsonNumber&>(value).value();
+
+        if (const auto* integer = std::get_if<std::int64_t>(&number))
+            append_int64(out, *integer);
+        else if (const auto* integer = std::get_if<std::uint64_t>(&number))
+            append_head(out, MajorType::UnsignedInteger, *integer);
+        else
+            append_double(out, std::get<double>(number));
+        break;
+    }
+    case JsonValueType::JsonString:
+        append_text(out, static_cast<const JsonString&>(value).view());
+        break;
+    case JsonValueType::JsonObject:
+        static_cast<const JsonObject&>(value).access([&out](const JsonObjectDict& dict) {
+                append_head(out, MajorType::Map, dict.size());
+
+                for (const auto& [key, member] : dict) {
+                    append_text(out, key.view());
+                    append_value(out, *member);
+                }
+                });
+        break;
+    case JsonValueType::JsonArray:
+        static_cast<const JsonArray&>(value).access([&out](const JsonArrayElements& elements) {
+                append_head(out, MajorType::Array, elements.size());
+
+                for (const auto& elem : elements)
+                    append_value(out, *elem);
+                });
+        break;
+    case JsonValueType::JsonNull:
+        out.push_back(static_cast<char>(simple_null));
+        break;
+    }
+}
+
+auto half_to_double(std::uint16_t half) -> double {
+    const auto exponent = (half >> 10) & 0x1f;
+    const auto mantissa = half & 0x3ff;
+
+    double result;
+
+    if (exponent == 0)
+        result = std::ldexp(mantissa, -24);
+    else if (exponent != 0x1f)
+        result = std::ldexp(mantissa + 0x400, exponent - 25);
+    else
+        result = mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+
+    return half & 0x8000 ? -result : result;
+}
+
+struct CborHead {
+    MajorType major;
+    std::uint8_t info;
+    std::uint64_t argument;
+};
+
+class CborReader {
+public:
+    CborReader(std::string_view input, const JsonCborOptions& options)
+        : m_input(input), m_options(options) {}
+
+    auto read_document() -> ErrorOr<std::shared_ptr<JsonValue>> {
+        auto value = TRY(read_value());
+
+        if (m_position != m_input.length())
+            return JsonError(JsonErrorCode::UnexpectedCharacter, m_position);
+
+        return value;
+    }
+
+private:
+    auto read_head() -> ErrorOr<CborHead> {
+        if (m_position == m_input.length())
+            return JsonError(JsonErrorCode::UnexpectedEndOfFile, m_position);
+
+        const auto initial = static_cast<std::uint8_t>(m_input[m_position]);
+        const auto head = CborHead{static_cast<MajorType>(initial >> 5), static_cast<std::uint8_t>(initial & 0x1f), 0};
+
+        if (head.info < one_byte_argument) {
+            m_position++;
+            return CborHead{head.major, head.info, head.info};
+        }
+
+        if (head.info == indefinite_length)
+            return JsonError(JsonErrorCode::UnsupportedItem, m_position, "indefinite length");
+
+        if (head.info > 27)
+            return JsonError(JsonErrorCode::UnexpectedCharacter, m_position);
+
+        // 24 to 27 are followed by 1, 2, 4 or 8 bytes.
+        const auto bytes = std::size_t{1} << (head.info - one_byte_argument);
+
+        if (m_input.length() - m_position - 1 < bytes)
+            return JsonError(JsonErrorCode::UnexpectedEndOfFile, m_input.length());
+
+        std::uint64_t argument = 0;
+
+        for (std::size_t i = 1; i <= bytes; i++)
+            argument = (argument << 8) | static_cast<std::uint8_t>(m_input[m_position + i]);
+
+        m_position += 1 + bytes;
+
+        return CborHead{head.major, head.info, argument};
+    }
+
+    auto read_value() -> ErrorOr<std::shared_ptr<JsonValue>> {
+        const auto start = m_position;
+        const auto head = TRY(read_head());
+
+        switch (head.major) {
+        case MajorType::UnsignedInteger:
+            return make_json_value<JsonNumber>(head.argument);
+        case MajorType::NegativeInteger:
+            if (head.argument > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()))
+                return JsonError(JsonErrorCode::NumberOutOfRange, start);
+
+            return make_json_value<JsonNumber>(static_cast<std::int64_t>(~head.argument));
+        case MajorType::TextString:
+            return make_json_value<JsonString>(std::string(TRY(read_text(head, start))));
+        case MajorType::Array:
+            return read_array(head.argument, start);
+        case MajorType::Map:
+            return read_map(head.argument, start);
+        case MajorType::ByteString:
+            return JsonError(JsonErrorCode::UnsupportedItem, start, "byte string");
+        case MajorType::Tag:
+            return JsonError(JsonErrorCode::UnsupportedItem, start, "tag");
+        case MajorType::Simple:
+            break;
+        }
+
+        switch (head.info) {
+        case 20:
+            return make_json_value<JsonBool>(false);
+        case 21:
+            return make_json_value<JsonBool>(true);
+        case 22:
+            return make_json_value<JsonNull>();
+        case 25:
+            return make_json_value<JsonNumber>(half_to_double(static_cast<std::uint16_t>(head.argument)));
+        case 26:
+            return make_json_value<JsonNumber>(static_cast<double>(std::bit_cast<float>(static_cast<std::uint32_t>(head.argument))));
+        case 27:
+            return make_json_value<JsonNumber>(std::bit_cast<double>(head.argument));
+        default:
+            break;
+        }
+
+        return JsonError(JsonErrorCode::UnsupportedItem, start, "simple value");
+    }
+
+    // the bytes of a text string whose head was just read.
+    auto read_text(const CborHead& head, std::size_t start) -> ErrorOr<std::string_view> {
+        if (head.argument > m_input.length() - m_position)
+            return JsonError(JsonErrorCode::UnexpectedEndOfFile, m_input.length());
+
+        const auto text = m_input.substr(m_position, head.argument);
+
+        if (not validate_utf8(text))
+            return JsonError(JsonErrorCode::InvalidUtf8, start);
+
+        m_position += text.length();
+
+        return text;
+    }
+
+    auto read_array(std::uint64_t count, std::size_t start) -> ErrorOr<std::shared_ptr<JsonValue>> {
+        TRY(enter(count, 1, start));
+
+        JsonArrayElements elements;
+        elements.reserve(count);
+
+        for (std::uint64_t i = 0; i < count; i++)
+            elements.push_back(TRY(read_value()));
+
+        m_depth--;
+
+        auto array = make_json_value<JsonArray>(JsonArray{});
+
+        array->access([&elements](JsonArrayElements& array_elements) {
+                array_elements = std::move(elements);
+                });
+
+        return array;
+    }
+
+    auto read_map(std::uint64_t count, std::size_t start) -> ErrorOr<std::shared_ptr<JsonValue>> {
+        TRY(enter(count, 2, start));
+
+        JsonObjectDict dict;
+        dict.reserve(count);
+
+        for (std::uint64_t i = 0; i < count; i++) {
+            const auto key_start = m_position;
+            const auto head = TRY(read_head());
+
+            if (head.major != MajorType::TextString)
+                return JsonError(JsonErrorCode::UnsupportedItem, key_start, "non-text key");
+
+            const auto key = TRY(read_text(head, key_start));
+
+            dict.insert_or_assign(JsonKey(key), TRY(read_value()));
+        }
+
+        m_depth--;
+
+        return make_json_value<JsonObject>(std::move(dict));
+    }
+
+    // checks the depth, and that what is left of the input can hold count
+    // items of at least item_bytes each before anything is reserved for
+    // them, a member of a map takes two.
+    auto enter(std::uint64_t count, std::size_t item_bytes, std::size_t start) -> ErrorOr<std::monostate> {
+        if (m_depth == m_options.max_depth)
+            return JsonError(JsonErrorCode::DepthLimitExceeded, start);
+
+        if (count > (m_input.length() - m_position) / item_bytes)
+            return JsonError(JsonErrorCode::UnexpectedEndOfFile, m_input.length());
+
+        m_depth++;
+
+        return std::monostate{};
+    }
+
+private:
+    std::string_view m_input;
+    std::size_t m_position{0};
+    std::size_t m_depth{0};
+
+    JsonCborOptions m_options;
+};
+
+}
+
+auto JsonCbor::encode(const JsonValue& value) -> std::string {
+    std::string result;
+
+    encode(value, result);
+
+    return result;
+}
+
+auto JsonCbor::encode(const JsonValue& value, std::string& out) -> void {
+    append_value(out, value);
+}
+
+auto JsonCbor::decode(std::string_view input, const JsonCborOptions& options) -> ErrorOr<std::shared_ptr<JsonValue>> {
+    CborReader reader(input, options);
+
+    return reader.read_document();
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "error.h"
+#include "jsonval.h"
+
+struct JsonCborOptions {
+    // arrays and maps nested deeper than this are rejected, a top level
+    // container is at depth 1.
+    std::size_t max_depth{1024};
+};
+
+// The JsonValue tree as CBOR (RFC 8949), for passing documents between
+// services without printing and lexing them again. Strings, arrays and maps
+// carry their length up front, so decoding never scans for a delimiter and
+// containers are reserved at their final size.
+//
+//   null, true, false   simple values 22, 21, 20
+//   int64, uint64       major types 0 and 1 in the shortest form
+//   double              float32 when that is exact, float64 otherwise
+//   string              text string
+//   array, object       definite length array and map, keys are text
+//
+// Numbers come back with the representation they went in with. Decoding
+// also takes float16, but rejects what json cannot hold: byte strings, tags,
+// indefinite lengths, undefined and the other simple values, and map keys
+// that are not text.
+class JsonCbor {
+public:
+    static auto encode(const JsonValue& value) -> std::string;
+
+    // appends to out, so one buffer can be reused for many messages.
+    static auto encode(const JsonValue& value, std::string& out) -> void;
+
+    // exactly one item, offsets in errors are byte offsets into input.
+    static auto decode(std::string_view input, const JsonCborOptions& options = {}) -> ErrorOr<std::shared_ptr<JsonValue>>;
+};
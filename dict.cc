@@ -0,0 +1,242 @@
+#include <functional>
+
+#include "dict.h"
+
+namespace {
+
+auto hash_key(std::string_view key) -> std::size_t {
+    return std::hash<std::string_view>{}(key);
+}
+
+}
+
+JsonObjectDict::JsonObjectDict(const JsonObjectDict& other)
+    : m_inline(other.m_inline), m_heap(other.m_heap), m_size(other.m_size), m_spilled(other.m_spilled), m_index(other.m_index) {}
+
+JsonObjectDict::JsonObjectDict(JsonObjectDict&& other)
+    : m_inline(std::move(other.m_inline)), m_heap(std::move(other.m_heap)), m_size(other.m_size), m_spilled(other.m_spilled), m_index(std::move(other.m_index))
+{
+    other.clear();
+}
+
+auto JsonObjectDict::operator=(const JsonObjectDict& other) -> JsonObjectDict& {
+    if (this == &other)
+        return *this;
+
+    m_inline = other.m_inline;
+    m_heap = other.m_heap;
+    m_size = other.m_size;
+    m_spilled = other.m_spilled;
+    m_index = other.m_index;
+
+    return *this;
+}
+
+auto JsonObjectDict::operator=(JsonObjectDict&& other) -> JsonObjectDict& {
+    if (this == &other)
+        return *this;
+
+    m_inline = std::move(other.m_inline);
+    m_heap = std::move(other.m_heap);
+    m_size = other.m_size;
+    m_spilled = other.m_spilled;
+    m_index = std::move(other.m_index);
+
+    other.clear();
+
+    return *this;
+}
+
+auto JsonObjectDict::operator[](std::string_view key) -> std::shared_ptr<JsonValue>& {
+    const auto index = find_index(key);
+
+    if (index != m_size)
+        return data()[index].second;
+
+    return append(JsonKey(key), nullptr).second;
+}
+
+auto JsonObjectDict::insert_or_assign(JsonKey key, std::shared_ptr<JsonValue> value) -> void {
+    const auto index = find_index(key.view());
+
+    if (index != m_size) {
+        data()[index].second = std::move(value);
+        return;
+    }
+
+    append(std::move(key), std::move(value));
+}
+
+auto JsonObjectDict::find(std::string_view key) -> iterator {
+    return data() + find_index(key);
+}
+
+auto JsonObjectDict::find(std::string_view key) const -> const_iterator {
+    return data() + find_index(key);
+}
+
+auto JsonObjectDict::find_key(const JsonKey& key) -> iterator {
+    return data() + find_index(key);
+}
+
+auto JsonObjectDict::find_key(const JsonKey& key) const -> const_iterator {
+    return data() + find_index(key);
+}
+
+auto JsonObjectDict::contains(std::string_view key) const -> bool {
+    return find_index(key) != m_size;
+}
+
+auto JsonObjectDict::erase(std::string_view key) -> bool {
+    const auto index = find_index(key);
+
+    if (index == m_size)
+        return false;
+
+    auto* members = data();
+
+    for (auto i = index; i + 1 < m_size; i++)
+        members[i] = std::move(members[i + 1]);
+
+    m_size--;
+
+    if (m_spilled)
+        m_heap.pop_back();
+    else
+        m_inline[m_size] = value_type{};
+
+    if (not m_index.empty())
+        rebuild_index();
+
+    return true;
+}
+
+auto JsonObjectDict::reserve(std::size_t capacity) -> void {
+    if (capacity <= inline_capacity or m_spilled) {
+        if (m_spilled)
+            m_heap.reserve(capacity);
+
+        return;
+    }
+
+    m_heap.reserve(capacity);
+
+    for (std::size_t i = 0; i < m_size; i++) {
+        m_heap.push_back(std::move(m_inline[i]));
+        m_inline[i] = value_type{};
+    }
+
+    m_spilled = true;
+}
+
+auto JsonObjectDict::clear() -> void {
+    for (std::size_t i = 0; i < inline_capacity and i < m_size; i++)
+        m_inline[i] = value_type{};
+
+    m_heap.clear();
+    m_index.clear();
+    m_size = 0;
+    m_spilled = false;
+}
+
+// position of the member, or m_size if there is none.
+auto JsonObjectDict::find_index(std::string_view key) const -> std::size_t {
+    const auto* members = data();
+
+    if (m_index.empty()) {
+        for (std::size_t i = 0; i < m_size; i++) {
+            if (members[i].first == key)
+                return i;
+        }
+
+        return m_size;
+    }
+
+    const auto mask = m_index.size() - 1;
+
+    for (auto slot = hash_key(key) & mask; m_index[slot] != 0; slot = (slot + 1) & mask) {
+        const auto member = m_index[slot] - 1;
+
+        if (members[member].first == key)
+            return member;
+    }
+
+    return m_size;
+}
+
+auto JsonObjectDict::find_index(const JsonKey& key) const -> std::size_t {
+    const auto* interned = key.interned_string();
+
+    if (not interned)
+        return find_index(key.view());
+
+    const auto* members = data();
+
+    if (m_index.empty()) {
+        for (std::size_t i = 0; i < m_size; i++) {
+            if (members[i].first.interned_string() == interned)
+                return i;
+        }
+    } else {
+        const auto mask = m_index.size() - 1;
+
+        for (auto slot = hash_key(key.view()) & mask; m_index[slot] != 0; slot = (slot + 1) & mask) {
+            const auto member = m_index[slot] - 1;
+
+            if (members[member].first.interned_string() == interned)
+                return member;
+        }
+    }
+
+    return find_index(key.view());
+}
+
+auto JsonObjectDict::append(JsonKey key, std::shared_ptr<JsonValue> value) -> value_type& {
+    if (not m_spilled and m_size == inline_capacity)
+        reserve(inline_capacity * 2);
+
+    if (m_spilled)
+        m_heap.emplace_back(std::move(key), std::move(value));
+    else
+        m_inline[m_size] = value_type(std::move(key), std::move(value));
+
+    m_size++;
+
+    if (m_size > index_threshold) {
+        // keep the table at most half full.
+        if (m_index.size() < m_size * 2)
+            rebuild_index();
+        else
+            index_insert(m_size - 1);
+    }
+
+    return data()[m_size - 1];
+}
+
+auto JsonObjectDict::index_insert(std::size_t member) -> void {
+    const auto mask = m_index.size() - 1;
+
+    auto slot = hash_key(data()[member].first.view()) & mask;
+
+    while (m_index[slot] != 0)
+        slot = (slot + 1) & mask;
+
+    m_index[slot] = static_cast<std::uint32_t>(member + 1);
+}
+
+auto JsonObjectDict::rebuild_index() -> void {
+    if (m_size <= index_threshold) {
+        m_index.clear();
+        return;
+    }
+
+    std::size_t capacity = 64;
+
+    while (capacity < m_size * 4)
+        capacity *= 2;
+
+    m_index.assign(capacity, 0);
+
+    for (std::size_t i = 0; i < m_size; i++)
+        index_insert(i);
+}
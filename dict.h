@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "intern.h"
+
+class JsonValue;
+
+// Members of a json object, kept contiguous and in insertion order so that
+// iteration and serialization are cheap and deterministic. The first two
+// members live inline in the object itself, a member is over 50 bytes so
+// more would make every small or empty object pay for them. Lookups are a
+// linear scan until the object grows past index_threshold members, from
+// then on an open addressing table of member indices is kept next to the
+// members.
+class JsonObjectDict {
+public:
+    using value_type = std::pair<JsonKey, std::shared_ptr<JsonValue>>;
+    using iterator = value_type*;
+    using const_iterator = const value_type*;
+
+    static constexpr std::size_t inline_capacity = 2;
+    static constexpr std::size_t index_threshold = 16;
+
+    JsonObjectDict() = default;
+
+    JsonObjectDict(const JsonObjectDict& other);
+
+    JsonObjectDict(JsonObjectDict&& other);
+
+    auto operator=(const JsonObjectDict& other) -> JsonObjectDict&;
+
+    auto operator=(JsonObjectDict&& other) -> JsonObjectDict&;
+
+    // the value for key, appended as an empty member if it is missing. the
+    // reference, like every iterator, is invalidated by the next insert,
+    // which may move the members out of line or reallocate them.
+    auto operator[](std::string_view key) -> std::shared_ptr<JsonValue>&;
+
+    // replaces the value of an existing member in place, appends otherwise.
+    auto insert_or_assign(JsonKey key, std::shared_ptr<JsonValue> value) -> void;
+
+    auto find(std::string_view key) -> iterator;
+
+    auto find(std::string_view key) const -> const_iterator;
+
+    // a key interned in the same table as the member's key is matched by
+    // its pointer alone. a miss still compares strings, the member may own
+    // its key or come from another table. a separate name, as a JsonKey
+    // converts from everything a string_view does.
+    auto find_key(const JsonKey& key) -> iterator;
+
+    auto find_key(const JsonKey& key) const -> const_iterator;
+
+    auto contains(std::string_view key) const -> bool;
+
+    // keeps the order of the remaining members.
+    auto erase(std::string_view key) -> bool;
+
+    auto reserve(std::size_t capacity) -> void;
+
+    auto clear() -> void;
+
+    auto size() const -> std::size_t { return m_size; }
+
+    auto empty() const -> bool { return m_size == 0; }
+
+    auto begin() -> iterator { return data(); }
+
+    auto end() -> iterator { return data() + m_size; }
+
+    auto begin() const -> const_iterator { return data(); }
+
+    auto end() const -> const_iterator { return data() + m_size; }
+
+private:
+    auto data() -> value_type* { return m_spilled ? m_heap.data() : m_inline.data(); }
+
+    auto data() const -> const value_type* { return m_spilled ? m_heap.data() : m_inline.data(); }
+
+    auto find_index(std::string_view key) const -> std::size_t;
+
+    auto find_index(const JsonKey& key) const -> std::size_t;
+
+    auto append(JsonKey key, std::shared_ptr<JsonValue> value) -> value_type&;
+
+    auto index_insert(std::size_t member) -> void;
+
+    auto rebuild_index() -> void;
+
+private:
+    std::array<value_type, inline_capacity> m_inline;
+    std::vector<value_type> m_heap;
+    std::size_t m_size{0};
+    bool m_spilled{false};
+
+    // member index + 1 per slot, 0 marks an empty slot.
+    std::vector<std::uint32_t> m_index;
+};
@@ -0,0 +1,367 @@
+#include <vector>
+
+#include "document.h"
+#include "query.h"
+
+namespace {
+
+// the member or element a pointer token refers to, nullptr if there is none.
+auto child(const JsonValue& node, const QueryStep& step) -> const JsonValue* {
+    const JsonValue* result = nullptr;
+
+    if (node.get_type() == JsonValueType::JsonObject) {
+        static_cast<const JsonObject&>(node).access([&](const JsonObjectDict& dict) {
+                if (const auto found = dict.find(step.name); found != dict.end())
+                    result = found->second.get();
+                });
+    } else if (node.get_type() == JsonValueType::JsonArray and step.has_index) {
+        static_cast<const JsonArray&>(node).access([&](const JsonArrayElements& elements) {
+                if (static_cast<std::size_t>(step.index) < elements.size())
+                    result = elements[static_cast<std::size_t>(step.index)].get();
+                });
+    }
+
+    return result;
+}
+
+auto dict_of(const JsonValue& value) -> const JsonObjectDict& {
+    const JsonObjectDict* result = nullptr;
+
+    static_cast<const JsonObject&>(value).access([&result](const JsonObjectDict& dict) {
+            result = &dict;
+            });
+
+    return *result;
+}
+
+auto elements_of(const JsonValue& value) -> const JsonArrayElements& {
+    const JsonArrayElements* result = nullptr;
+
+    static_cast<const JsonArray&>(value).access([&result](const JsonArrayElements& elements) {
+            result = &elements;
+            });
+
+    return *result;
+}
+
+// byte offset of every reference token in a json pointer, escapes never
+// contain a '/', so the slashes split it exactly.
+auto token_offsets(std::string_view pointer) -> std::vector<std::size_t> {
+    std::vector<std::size_t> offsets;
+
+    for (std::size_t i = 0; i < pointer.length(); i++) {
+        if (pointer[i] == '/')
+            offsets.push_back(i + 1);
+    }
+
+    return offsets;
+}
+
+// copies the nodes along the path, everything else is shared with the old
+// tree. a copied container is a fresh node holding the same children, so
+// nothing a reader can see is ever written to. containers hold their
+// children as mutable pointers, the casts below are safe because documents
+// never hand those out.
+class PathUpdate {
+public:
+    PathUpdate(const std::vector<QueryStep>& steps, std::vector<std::size_t> offsets, std::shared_ptr<const JsonValue> value)
+        : m_steps(steps), m_offsets(std::move(offsets)), m_value(std::move(value)) {}
+
+    auto apply(const JsonValue& node, std::size_t depth) const -> ErrorOr<std::shared_ptr<const JsonValue>> {
+        if (depth == m_steps.size())
+            return m_value;
+
+        switch (node.get_type()) {
+        case JsonValueType::JsonObject:
+            return apply_object(static_cast<const JsonObject&>(node), depth);
+        case JsonValueType::JsonArray:
+            return apply_array(static_cast<const JsonArray&>(node), depth);
+        default:
+            break;
+        }
+
+        return JsonError::type_mismatch("object or array", node.get_type(), m_offsets[depth]);
+    }
+
+private:
+    auto is_last(std::size_t depth) const -> bool {
+        return depth + 1 == m_steps.size();
+    }
+
+    auto apply_object(const JsonObject& object, std::size_t depth) const -> ErrorOr<std::shared_ptr<const JsonValue>> {
+        const auto& step = m_steps[depth];
+
+        JsonObjectDict dict;
+
+        object.access([&dict](const JsonObjectDict& members) {
+                dict = members;
+                });
+
+        const auto found = dict.find(step.name);
+
+        if (found == dict.end()) {
+            if (not is_last(depth))
+                return JsonError(JsonErrorCode::KeyNotFound, m_offsets[depth], step.name);
+
+            dict.insert_or_assign(JsonKey(step.name), std::const_pointer_cast<JsonValue>(m_value));
+        } else {
+            // replaced in place, the member keeps its position.
+            found->second = std::const_pointer_cast<JsonValue>(TRY(apply(*found->second, depth + 1)));
+        }
+
+        return make_json_value<JsonObject>(std::move(dict));
+    }
+
+    auto apply_array(const JsonArray& array, std::size_t depth) const -> ErrorOr<std::shared_ptr<const JsonValue>> {
+        const auto& step = m_steps[depth];
+
+        JsonArrayElements elements;
+
+        array.access([&elements](const JsonArrayElements& original) {
+                elements = original;
+                });
+
+        const auto appends = step.name == "-" or (step.has_index and static_cast<std::size_t>(step.index) == elements.size());
+
+        if (appends and is_last(depth)) {
+            elements.push_back(std::const_pointer_cast<JsonValue>(m_value));
+        } else if (step.has_index and static_cast<std::size_t>(step.index) < elements.size()) {
+            auto& element = elements[static_cast<std::size_t>(step.index)];
+
+            element = std::const_pointer_cast<JsonValue>(TRY(apply(*element, depth + 1)));
+        } else if (step.has_index or appends) {
+            return JsonError::index_out_of_range(step.has_index ? static_cast<std::size_t>(step.index) : elements.size(), m_offsets[depth]);
+        } else {
+            return JsonError::type_mismatch("object", JsonValueType::JsonArray, m_offsets[depth]);
+        }
+
+        auto result = make_json_value<JsonArray>(JsonArray{});
+
+        result->access([&elements](JsonArrayElements& array_elements) {
+                array_elements = std::move(elements);
+                });
+
+        return result;
+    }
+
+private:
+    const std::vector<QueryStep>& m_steps;
+    std::vector<std::size_t> m_offsets;
+    std::shared_ptr<const JsonValue> m_value;
+};
+
+}
+
+auto JsonDocumentRef::ElementIterator::operator*() const -> JsonDocumentRef {
+    return JsonDocumentRef(**m_element);
+}
+
+auto JsonDocumentRef::ElementIterator::operator++() -> ElementIterator& {
+    m_element++;
+
+    return *this;
+}
+
+auto JsonDocumentRef::MemberIterator::operator*() const -> std::pair<std::string_view, JsonDocumentRef> {
+    return {m_member->first.view(), JsonDocumentRef(*m_member->second)};
+}
+
+auto JsonDocumentRef::MemberIterator::operator++() -> MemberIterator& {
+    m_member++;
+
+    return *this;
+}
+
+auto JsonDocumentRef::get_type() const -> JsonValueType {
+    return m_value->get_type();
+}
+
+auto JsonDocumentRef::as_bool() const -> std::optional<bool> {
+    if (get_type() != JsonValueType::JsonBool)
+        return std::nullopt;
+
+    bool result = false;
+
+    static_cast<const JsonBool*>(m_value)->access([&result](const bool& boolean) {
+            result = boolean;
+            });
+
+    return result;
+}
+
+auto JsonDocumentRef::as_number() const -> std::optional<double> {
+    if (get_type() != JsonValueType::JsonNumber)
+        return std::nullopt;
+
+    return static_cast<const JsonNumber*>(m_value)->as_double();
+}
+
+auto JsonDocumentRef::as_int64() const -> std::optional<std::int64_t> {
+    if (get_type() != JsonValueType::JsonNumber)
+        return std::nullopt;
+
+    return static_cast<const JsonNumber*>(m_value)->as_int64();
+}
+
+auto JsonDocumentRef::as_uint64() const -> std::optional<std::uint64_t> {
+    if (get_type() != JsonValueType::JsonNumber)
+        return std::nullopt;
+
+    return static_cast<const JsonNumber*>(m_value)->as_uint64();
+}
+
+auto JsonDocumentRef::as_string() const -> std::optional<std::string_view> {
+    if (get_type() != JsonValueType::JsonString)
+        return std::nullopt;
+
+    return static_cast<const JsonString*>(m_value)->view();
+}
+
+auto JsonDocumentRef::size() const -> std::size_t {
+    switch (get_type()) {
+    case JsonValueType::JsonObject:
+        return dict_of(*m_value).size();
+    case JsonValueType::JsonArray:
+        return elements_of(*m_value).size();
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+auto JsonDocumentRef::find(std::string_view key) const -> std::optional<JsonDocumentRef> {
+    if (get_type() != JsonValueType::JsonObject)
+        return std::nullopt;
+
+    const auto& dict = dict_of(*m_value);
+    const auto found = dict.find(key);
+
+    if (found == dict.end())
+        return std::nullopt;
+
+    return JsonDocumentRef(*found->second);
+}
+
+auto JsonDocumentRef::at(std::size_t index) const -> std::optional<JsonDocumentRef> {
+    if (get_type() != JsonValueType::JsonArray)
+        return std::nullopt;
+
+    const auto& elements = elements_of(*m_value);
+
+    if (index >= elements.size())
+        return std::nullopt;
+
+    return JsonDocumentRef(*elements[index]);
+}
+
+auto JsonDocumentRef::elements() const -> Range<ElementIterator> {
+    if (get_type() != JsonValueType::JsonArray)
+        return Range<ElementIterator>(nullptr, nullptr);
+
+    const auto& elements = elements_of(*m_value);
+
+    return Range<ElementIterator>(elements.data(), elements.data() + elements.size());
+}
+
+auto JsonDocumentRef::members() const -> Range<MemberIterator> {
+    if (get_type() != JsonValueType::JsonObject)
+        return Range<MemberIterator>(nullptr, nullptr);
+
+    const auto& dict = dict_of(*m_value);
+
+    return Range<MemberIterator>(dict.begin(), dict.end());
+}
+
+auto JsonDocumentRef::serialize(const JsonWriterOptions& options) const -> std::string {
+    return m_value->serialize(options);
+}
+
+JsonDocument::JsonDocument()
+    : m_root(make_json_value<JsonNull>()) {}
+
+JsonDocument::JsonDocument(std::shared_ptr<const JsonValue> root)
+    : m_root(std::move(root)) {}
+
+JsonDocument::JsonDocument(JsonObject root)
+    : m_root(std::make_shared<const JsonObject>(std::move(root))) {}
+
+auto JsonDocument::root() const -> JsonDocumentRef {
+    return JsonDocumentRef(*m_root);
+}
+
+auto JsonDocument::find(std::string_view pointer) const -> ErrorOr<std::optional<JsonDocumentRef>> {
+    const auto query = TRY(JsonQuery::compile_pointer(pointer));
+
+    const JsonValue* node = m_root.get();
+
+    for (const auto& step : query.steps()) {
+        node = child(*node, step);
+
+        if (not node)
+            return std::optional<JsonDocumentRef>();
+    }
+
+    return std::optional<JsonDocumentRef>(JsonDocumentRef(*node));
+}
+
+auto JsonDocument::set(std::string_view pointer, const JsonDocument& value) const -> ErrorOr<JsonDocument> {
+    return set_value(pointer, value.m_root);
+}
+
+auto JsonDocument::serialize(const JsonWriterOptions& options) const -> std::string {
+    return m_root->serialize(options);
+}
+
+auto JsonDocument::set_value(std::string_view pointer, std::shared_ptr<const JsonValue> value) const -> ErrorOr<JsonDocument> {
+    const auto query = TRY(JsonQuery::compile_pointer(pointer));
+
+    const PathUpdate update(query.steps(), token_offsets(pointer), std::move(value));
+
+    return JsonDocument(TRY(update.apply(*m_root, 0)));
+}
+
+JsonDocumentRoot::JsonDocumentRoot(JsonDocument document)
+    : m_root(std::move(document.m_root)) {}
+
+auto JsonDocumentRoot::load() const -> JsonDocument {
+    return JsonDocument(m_root.load(std::memory_order_acquire));
+}
+
+auto JsonDocumentRoot::store(JsonDocument document) -> void {
+    m_root.store(std::move(document.m_root), std::memory_order_release);
+    m_version.fetch_add(1, std::memory_order_release);
+}
+
+auto JsonDocumentRoot::update(const std::function<ErrorOr<JsonDocument>(const JsonDocument&)>& next_version) -> ErrorOr<JsonDocument> {
+    auto current = m_root.load(std::memory_order_acquire);
+
+    while (true) {
+        const auto next = TRY(next_version(JsonDocument(current)));
+
+        if (m_root.compare_exchange_weak(current, next.m_root, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            m_version.fetch_add(1, std::memory_order_release);
+            return next;
+        }
+    }
+}
+
+auto JsonDocumentRoot::version() const -> std::uint64_t {
+    return m_version.load(std::memory_order_acquire);
+}
+
+JsonDocumentReader::JsonDocumentReader(const JsonDocumentRoot& root)
+    : m_root(root), m_version(root.version()), m_snapshot(root.load()) {}
+
+auto JsonDocumentReader::get() -> const JsonDocument& {
+    const auto version = m_root.version();
+
+    // a version read before the root can only make the snapshot newer than
+    // it claims, which costs one extra reload at most.
+    if (version != m_version) {
+        m_snapshot = m_root.load();
+        m_version = version;
+    }
+
+    return m_snapshot;
+}
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "error.h"
+#include "jsonval.h"
+
+// A read-only handle on a value inside a JsonDocument, valid for as long as
+// some document holding that version is. It only ever hands out more
+// handles, never the JsonValue nodes themselves, whose children could be
+// changed through access() even from a const node.
+class JsonDocumentRef {
+public:
+    class ElementIterator {
+    public:
+        ElementIterator(const std::shared_ptr<JsonValue>* element)
+            : m_element(element) {}
+
+        auto operator*() const -> JsonDocumentRef;
+
+        auto operator++() -> ElementIterator&;
+
+        auto operator==(const ElementIterator& other) const -> bool {
+            return m_element == other.m_element;
+        }
+
+    private:
+        const std::shared_ptr<JsonValue>* m_element;
+    };
+
+    class MemberIterator {
+    public:
+        MemberIterator(const JsonObjectDict::value_type* member)
+            : m_member(member) {}
+
+        auto operator*() const -> std::pair<std::string_view, JsonDocumentRef>;
+
+        auto operator++() -> MemberIterator&;
+
+        auto operator==(const MemberIterator& other) const -> bool {
+            return m_member == other.m_member;
+        }
+
+    private:
+        const JsonObjectDict::value_type* m_member;
+    };
+
+    template <typename Iterator>
+    class Range {
+    public:
+        Range(Iterator begin, Iterator end)
+            : m_begin(begin), m_end(end) {}
+
+        auto begin() const -> Iterator { return m_begin; }
+
+        auto end() const -> Iterator { return m_end; }
+
+    private:
+        Iterator m_begin;
+        Iterator m_end;
+    };
+
+    auto get_type() const -> JsonValueType;
+
+    auto as_bool() const -> std::optional<bool>;
+
+    // any number, integers beyond 2^53 are rounded.
+    auto as_number() const -> std::optional<double>;
+
+    auto as_int64() const -> std::optional<std::int64_t>;
+
+    auto as_uint64() const -> std::optional<std::uint64_t>;
+
+    auto as_string() const -> std::optional<std::string_view>;
+
+    // number of elements or members, zero for scalars.
+    auto size() const -> std::size_t;
+
+    auto find(std::string_view key) const -> std::optional<JsonDocumentRef>;
+
+    auto at(std::size_t index) const -> std::optional<JsonDocumentRef>;
+
+    // only meaningful on arrays.
+    auto elements() const -> Range<ElementIterator>;
+
+    // only meaningful on objects.
+    auto members() const -> Range<MemberIterator>;
+
+    auto serialize(const JsonWriterOptions& options = {}) const -> std::string;
+
+    // the very same node, which versions share wherever they did not change.
+    auto is_same(const JsonDocumentRef& other) const -> bool {
+        return m_value == other.m_value;
+    }
+
+private:
+    friend class JsonDocument;
+
+    JsonDocumentRef(const JsonValue& value)
+        : m_value(&value) {}
+
+    const JsonValue* m_value;
+};
+
+// A json tree that is never changed once it is built, so any number of
+// threads can read it without a lock. Updates are persistent: set() returns
+// a new document that copies only the nodes on the path to the change and
+// shares every other subtree with the old one, which stays valid as is.
+//
+// A document owns what it is built from, values are moved in, and it is
+// only ever read through JsonDocumentRef, so nothing reachable from it can
+// be changed.
+class JsonDocument {
+public:
+    // a null document.
+    JsonDocument();
+
+    JsonDocument(JsonObject root);
+
+    auto root() const -> JsonDocumentRef;
+
+    // the value at a json pointer (RFC 6901), nullopt if there is none.
+    // error offsets are byte offsets into pointer.
+    auto find(std::string_view pointer) const -> ErrorOr<std::optional<JsonDocumentRef>>;
+
+    // a new document with value at pointer. the parent has to exist, an
+    // object member is replaced or appended, an array element is replaced,
+    // and the index one past the end or "-" appends. an empty pointer
+    // replaces the root. error offsets are byte offsets into pointer.
+    template <typename T, typename = std::enable_if_t<std::is_base_of_v<JsonValue, T>>>
+    auto set(std::string_view pointer, T value) const -> ErrorOr<JsonDocument> {
+        return set_value(pointer, std::make_shared<const T>(std::move(value)));
+    }
+
+    // the same with the whole of another document, which is shared, not
+    // copied.
+    auto set(std::string_view pointer, const JsonDocument& value) const -> ErrorOr<JsonDocument>;
+
+    auto serialize(const JsonWriterOptions& options = {}) const -> std::string;
+
+private:
+    friend class JsonDocumentRoot;
+
+    JsonDocument(std::shared_ptr<const JsonValue> root);
+
+    auto set_value(std::string_view pointer, std::shared_ptr<const JsonValue> value) const -> ErrorOr<JsonDocument>;
+
+private:
+    std::shared_ptr<const JsonValue> m_root;
+};
+
+// The current version of a document, shared between readers and writers.
+// Writers publish whole new versions, readers take a snapshot and keep
+// using it for as long as they like, even after newer versions are out.
+//
+// The root is an std::atomic<std::shared_ptr>. It is not lock-free in
+// libstdc++, loads and stores take a short internal lock, so a snapshot can
+// wait for a writer that is publishing, though never for one still building
+// its next version. Every load also touches the reference count every reader
+// shares. Hot readers should go through JsonDocumentReader, which only
+// reloads when the version changed.
+class JsonDocumentRoot {
+public:
+    JsonDocumentRoot(JsonDocument document = {});
+
+    JsonDocumentRoot(const JsonDocumentRoot& other) = delete;
+
+    auto operator=(const JsonDocumentRoot& other) -> JsonDocumentRoot& = delete;
+
+    auto load() const -> JsonDocument;
+
+    auto store(JsonDocument document) -> void;
+
+    // builds the next version from the current one and publishes it. if
+    // another writer published in between, update runs again on theirs.
+    auto update(const std::function<ErrorOr<JsonDocument>(const JsonDocument&)>& next_version) -> ErrorOr<JsonDocument>;
+
+    // bumped after every publish.
+    auto version() const -> std::uint64_t;
+
+private:
+    std::atomic<std::shared_ptr<const JsonValue>> m_root;
+    std::atomic<std::uint64_t> m_version{0};
+};
+
+// One thread's view of a JsonDocumentRoot. get() costs a single atomic load
+// of the version while nothing was published, the snapshot is only swapped
+// when it changed, so readers do not fight over the reference count. Not
+// to be shared between threads, give each reader its own.
+class JsonDocumentReader {
+public:
+    JsonDocumentReader(const JsonDocumentRoot& root);
+
+    // stays valid until the next call.
+    auto get() -> const JsonDocument&;
+
+private:
+    const JsonDocumentRoot& m_root;
+
+    // read before the snapshot is taken.
+    std::uint64_t m_version;
+    JsonDocument m_snapshot;
+};
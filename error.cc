@@ -0,0 +1,248 @@
+#include <algorithm>
+#include <cstring>
+
+#include "error.h"
+
+auto error_code_to_string(JsonErrorCode code) -> std::string_view {
+    switch (code) {
+    case JsonErrorCode::ExpectedToken:
+        return "expected token";
+    case JsonErrorCode::UnexpectedToken:
+        return "unexpected token";
+    case JsonErrorCode::UnexpectedEndOfFile:
+        return "unexpected end of file";
+    case JsonErrorCode::UnexpectedCharacter:
+        return "unexpected character";
+    case JsonErrorCode::InvalidEscape:
+        return "invalid escape";
+    case JsonErrorCode::InvalidUtf8:
+        return "invalid utf-8";
+    case JsonErrorCode::DepthLimitExceeded:
+        return "depth limit exceeded";
+    case JsonErrorCode::NumberOutOfRange:
+        return "number out of range";
+    case JsonErrorCode::InputTooLarge:
+        return "input too large";
+    case JsonErrorCode::KeyNotFound:
+        return "key not found";
+    case JsonErrorCode::IndexOutOfRange:
+        return "index out of range";
+    case JsonErrorCode::TypeMismatch:
+        return "type mismatch";
+    case JsonErrorCode::InvalidQuery:
+        return "invalid query";
+    case JsonErrorCode::UnknownField:
+        return "unknown field";
+    case JsonErrorCode::MissingField:
+        return "missing field";
+    case JsonErrorCode::IntegerOutOfRange:
+        return "integer out of range";
+    case JsonErrorCode::NotAnInteger:
+        return "not an integer";
+    case JsonErrorCode::FileError:
+        return "file error";
+    case JsonErrorCode::UnsupportedItem:
+        return "unsupported item";
+    case JsonErrorCode::InvalidImage:
+        return "invalid image";
+    }
+
+    return "unknown";
+}
+
+JsonError::JsonError(JsonErrorCode code, std::size_t offset, std::string_view context)
+    : m_code(code), m_offset(offset)
+{
+    if (context.length() <= max_context_length) {
+        std::copy(context.begin(), context.end(), m_context.begin());
+        m_context_length = static_cast<std::uint8_t>(context.length());
+        return;
+    }
+
+    // keep the start, that is the part that identifies the literal.
+    const auto kept = max_context_length - 3;
+
+    std::copy_n(context.begin(), kept, m_context.begin());
+    std::copy_n("...", 3, m_context.begin() + kept);
+
+    m_context_length = static_cast<std::uint8_t>(max_context_length);
+}
+
+auto JsonError::expected_token(TokenType expected, TokenType actual, std::size_t offset) -> JsonError {
+    JsonError error(JsonErrorCode::ExpectedToken, offset);
+
+    error.m_expected = expected;
+    error.m_actual = actual;
+
+    return error;
+}
+
+auto JsonError::unexpected_token(TokenType actual, std::size_t offset) -> JsonError {
+    if (actual == TokenType::EndOfFile)
+        return JsonError(JsonErrorCode::UnexpectedEndOfFile, offset);
+
+    JsonError error(JsonErrorCode::UnexpectedToken, offset);
+
+    error.m_actual = actual;
+
+    return error;
+}
+
+auto JsonError::index_out_of_range(std::size_t index, std::size_t offset) -> JsonError {
+    JsonError error(JsonErrorCode::IndexOutOfRange, offset);
+
+    error.m_detail = index;
+
+    return error;
+}
+
+auto JsonError::type_mismatch(std::string_view expected, JsonValueType actual, std::size_t offset) -> JsonError {
+    JsonError error(JsonErrorCode::TypeMismatch, offset);
+
+    error.m_reason = expected;
+    error.m_detail = static_cast<std::uint64_t>(actual);
+
+    return error;
+}
+
+auto JsonError::invalid_query(std::string_view expression, std::string_view reason, std::size_t offset) -> JsonError {
+    JsonError error(JsonErrorCode::InvalidQuery, offset, expression);
+
+    error.m_reason = reason;
+
+    return error;
+}
+
+auto JsonError::file_error(std::string_view path, std::string_view what, int error_number) -> JsonError {
+    JsonError error(JsonErrorCode::FileError, 0, path);
+
+    error.m_reason = what;
+    error.m_detail = static_cast<std::uint64_t>(error_number);
+
+    return error;
+}
+
+auto JsonError::code() const -> JsonErrorCode {
+    return m_code;
+}
+
+auto JsonError::offset() const -> std::size_t {
+    return m_offset;
+}
+
+auto JsonError::expected() const -> TokenType {
+    return m_expected;
+}
+
+auto JsonError::actual() const -> TokenType {
+    return m_actual;
+}
+
+auto JsonError::context() const -> std::string_view {
+    return std::string_view(m_context.data(), m_context_length);
+}
+
+auto JsonError::reason() const -> std::string_view {
+    return m_reason;
+}
+
+auto JsonError::detail() const -> std::uint64_t {
+    return m_detail;
+}
+
+auto JsonError::location(std::string_view input) const -> JsonLocation {
+    const auto end = std::min(m_offset, input.length());
+    const auto before = input.substr(0, end);
+
+    const auto line = static_cast<std::size_t>(std::count(before.begin(), before.end(), '\n')) + 1;
+    const auto line_start = before.rfind('\n');
+
+    if (line_start == std::string_view::npos)
+        return JsonLocation{line, end + 1};
+
+    return JsonLocation{line, end - line_start};
+}
+
+auto JsonError::message() const -> std::string {
+    std::string result;
+
+    append_description(result);
+
+    if (has_offset()) {
+        result.append(" at byte ");
+        result.append(std::to_string(m_offset));
+    }
+
+    return result;
+}
+
+auto JsonError::message(std::string_view input) const -> std::string {
+    std::string result;
+
+    append_description(result);
+
+    if (has_offset()) {
+        const auto [line, column] = location(input);
+
+        result.append(" at line ");
+        result.append(std::to_string(line));
+        result.append(", column ");
+        result.append(std::to_string(column));
+    }
+
+    return result;
+}
+
+auto JsonError::append_description(std::string& out) const -> void {
+    out.append("ERROR: ");
+
+    switch (m_code) {
+    case JsonErrorCode::ExpectedToken:
+        out.append("expected: ");
+        out.append(token_to_string(m_expected));
+        out.append(" but got: ");
+        out.append(token_to_string(m_actual));
+        return;
+    case JsonErrorCode::UnexpectedToken:
+        out.append("unexpected token: ");
+        out.append(token_to_string(m_actual));
+        return;
+    case JsonErrorCode::TypeMismatch:
+        out.append("expected: ");
+        out.append(m_reason);
+        out.append(" but got: ");
+        out.append(value_type_to_string(static_cast<JsonValueType>(m_detail)));
+        return;
+    case JsonErrorCode::IndexOutOfRange:
+        out.append("index out of range: ");
+        out.append(std::to_string(m_detail));
+        return;
+    case JsonErrorCode::InvalidQuery:
+        out.append("invalid query: ");
+        out.append(context());
+        out.append(": ");
+        out.append(m_reason);
+        return;
+    case JsonErrorCode::FileError:
+        out.append(m_reason);
+        out.append(" '");
+        out.append(context());
+        out.append("': ");
+        out.append(std::strerror(static_cast<int>(m_detail)));
+        return;
+    default:
+        break;
+    }
+
+    // the rest is the code followed by the context, if there is one.
+    out.append(error_code_to_string(m_code));
+
+    if (m_context_length != 0) {
+        out.append(": ");
+        out.append(context());
+    }
+}
+
+auto JsonError::has_offset() const -> bool {
+    return m_code != JsonErrorCode::FileError and m_code != JsonErrorCode::InputTooLarge and m_code != JsonErrorCode::InvalidImage;
+}
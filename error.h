@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <variant>
+
+#include "jsonval.h"
+#include "lexer.h"
+
+enum class JsonErrorCode : std::uint8_t {
+    // expected() is the token that was required, actual() the one found.
+    ExpectedToken,
+    UnexpectedToken,
+    UnexpectedEndOfFile,
+    UnexpectedCharacter,
+    InvalidEscape,
+    InvalidUtf8,
+    DepthLimitExceeded,
+    NumberOutOfRange,
+    InputTooLarge,
+    KeyNotFound,
+    IndexOutOfRange,
+    TypeMismatch,
+    InvalidQuery,
+    UnknownField,
+    MissingField,
+    IntegerOutOfRange,
+    // a fraction or exponent where a bound struct wants an integer.
+    NotAnInteger,
+    FileError,
+    // binary input holding something json has no equivalent for, context()
+    // names it.
+    UnsupportedItem,
+    // a saved image that cannot be used, context() says why.
+    InvalidImage,
+};
+
+auto error_code_to_string(JsonErrorCode code) -> std::string_view;
+
+struct JsonLocation {
+    // both start at 1, columns count bytes.
+    std::size_t line;
+    std::size_t column;
+};
+
+// What went wrong and where, in a fixed size that never allocates. Nothing
+// is formatted until message() is called, so rejecting input costs about
+// as much as accepting it.
+//
+// The context (the offending literal, key or path) is copied in and cut
+// short past max_context_length, so an error may outlive its input. The
+// reason is only ever a string literal.
+class JsonError {
+public:
+    static constexpr std::size_t max_context_length = 36;
+
+    JsonError(JsonErrorCode code, std::size_t offset, std::string_view context = {});
+
+    static auto expected_token(TokenType expected, TokenType actual, std::size_t offset) -> JsonError;
+
+    // an end of file token comes back as UnexpectedEndOfFile.
+    static auto unexpected_token(TokenType actual, std::size_t offset) -> JsonError;
+
+    static auto index_out_of_range(std::size_t index, std::size_t offset) -> JsonError;
+
+    // expected names the type that was asked for, e.g. "object or array".
+    static auto type_mismatch(std::string_view expected, JsonValueType actual, std::size_t offset) -> JsonError;
+
+    // offset is the position in the expression.
+    static auto invalid_query(std::string_view expression, std::string_view reason, std::size_t offset) -> JsonError;
+
+    // what is e.g. "cannot open", the errno value is kept as detail().
+    static auto file_error(std::string_view path, std::string_view what, int error_number) -> JsonError;
+
+    auto code() const -> JsonErrorCode;
+
+    // bytes from the start of the input, or of the query expression.
+    auto offset() const -> std::size_t;
+
+    auto expected() const -> TokenType;
+
+    auto actual() const -> TokenType;
+
+    auto context() const -> std::string_view;
+
+    auto reason() const -> std::string_view;
+
+    auto detail() const -> std::uint64_t;
+
+    // counts the newlines before offset(), input has to be the text that
+    // was parsed.
+    auto location(std::string_view input) const -> JsonLocation;
+
+    // "ERROR: expected: : but got: , at byte 12".
+    auto message() const -> std::string;
+
+    // the same with a line and column in input instead of the byte offset.
+    auto message(std::string_view input) const -> std::string;
+
+private:
+    auto append_description(std::string& out) const -> void;
+
+    auto has_offset() const -> bool;
+
+private:
+    JsonErrorCode m_code;
+    TokenType m_expected{TokenType::Garbage};
+    TokenType m_actual{TokenType::Garbage};
+    std::uint8_t m_context_length{0};
+    std::array<char, max_context_length> m_context;
+
+    std::size_t m_offset;
+    std::uint64_t m_detail{0};
+    std::string_view m_reason;
+};
+
+template <typename T>
+using ErrorOr = std::variant<JsonError, T>;
+
+#define TRY(...)\
+    ({\
+     auto res = __VA_ARGS__;\
+     if (std::holds_alternative<JsonError>(res))\
+        return std::get<0>(res);\
+     std::move(std::get<1>(res));\
+     })\
+
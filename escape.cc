@@ -0,0 +1,638 @@
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "escape.h"
+
+namespace {
+
+constexpr std::size_t block_size = 32;
+
+struct StringMasks {
+    std::uint32_t quote;
+    std::uint32_t backslash;
+    std::uint32_t non_ascii;
+    std::uint32_t control;
+};
+
+using ClassifyBlock = auto (*)(const char*) -> StringMasks;
+
+auto classify_scalar(const char* block) -> StringMasks {
+    StringMasks masks{};
+
+    for (std::size_t i = 0; i < block_size; i++) {
+        const auto bit = std::uint32_t{1} << i;
+        const auto byte = static_cast<unsigned char>(block[i]);
+
+        if (byte == '"')
+            masks.quote |= bit;
+        else if (byte == '\\')
+            masks.backslash |= bit;
+        else if (byte >= 0x80)
+            masks.non_ascii |= bit;
+        else if (byte < 0x20)
+            masks.control |= bit;
+    }
+
+    return masks;
+}
+
+#if defined(__x86_64__)
+
+auto classify_sse2(const char* block) -> StringMasks {
+    StringMasks masks{};
+
+    for (std::size_t i = 0; i < block_size; i += 16) {
+        const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+        const auto bits = [](__m128i mask) {
+            return static_cast<std::uint32_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(mask)));
+        };
+
+        // signed, so both the control characters and everything from 0x80
+        // up are below 0x20.
+        const auto below_space = bits(_mm_cmpgt_epi8(_mm_set1_epi8(0x20), chunk));
+        const auto non_ascii = bits(chunk);
+
+        masks.quote |= bits(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'))) << i;
+        masks.backslash |= bits(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))) << i;
+        masks.non_ascii |= non_ascii << i;
+        masks.control |= (below_space & ~non_ascii) << i;
+    }
+
+    return masks;
+}
+
+__attribute__((target("avx2")))
+auto classify_avx2(const char* block) -> StringMasks {
+    const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const auto bits = [](__m256i mask) __attribute__((target("avx2"))) {
+        return static_cast<std::uint32_t>(_mm256_movemask_epi8(mask));
+    };
+
+    const auto below_space = bits(_mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), chunk));
+    const auto non_ascii = bits(chunk);
+
+    return StringMasks{
+        .quote = bits(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'))),
+        .backslash = bits(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'))),
+        .non_ascii = non_ascii,
+        .control = below_space & ~non_ascii,
+    };
+}
+
+#endif
+
+auto select_classifier(SimdLevel level) -> ClassifyBlock {
+#if defined(__x86_64__)
+    if (level > detect_simd_level())
+        level = detect_simd_level();
+
+    switch (level) {
+    case SimdLevel::Avx2:
+        return classify_avx2;
+    case SimdLevel::Sse2:
+        return classify_sse2;
+    case SimdLevel::Scalar:
+        break;
+    }
+#else
+    (void)level;
+#endif
+
+    return classify_scalar;
+}
+
+auto hex_value(char c) -> int {
+    if (c >= '0' and c <= '9')
+        return c - '0';
+
+    if (c >= 'a' and c <= 'f')
+        return c - 'a' + 10;
+
+    if (c >= 'A' and c <= 'F')
+        return c - 'A' + 10;
+
+    return -1;
+}
+
+auto append_utf8(std::string& out, std::uint32_t code_point) -> void {
+    if (code_point < 0x80) {
+        out.push_back(static_cast<char>(code_point));
+    } else if (code_point < 0x800) {
+        out.push_back(static_cast<char>(0xc0 | (code_point >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+    } else if (code_point < 0x10000) {
+        out.push_back(static_cast<char>(0xe0 | (code_point >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+    } else {
+        out.push_back(static_cast<char>(0xf0 | (code_point >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3f)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3f)));
+    }
+}
+
+// without avx2 only runs of ascii are skipped in bulk, with sse2, every
+// other byte goes through utf8_sequence_length.
+auto validate_utf8_sequences(std::string_view text, SimdLevel level) -> bool {
+    std::size_t i = 0;
+
+    while (i < text.length()) {
+#if defined(__x86_64__)
+        while (level >= SimdLevel::Sse2 and i + 16 <= text.length()) {
+            const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i));
+
+            if (_mm_movemask_epi8(chunk) != 0)
+                break;
+
+            i += 16;
+        }
+#endif
+
+        if (i == text.length())
+            break;
+
+        if (static_cast<unsigned char>(text[i]) < 0x80) {
+            i++;
+            continue;
+        }
+
+        const auto length = utf8_sequence_length(text.substr(i));
+
+        if (length == 0)
+            return false;
+
+        i += length;
+    }
+
+    return true;
+}
+
+#if defined(__x86_64__)
+
+// The lookup based validator of Keiser and Lemire, "Validating UTF-8 In
+// Less Than One Instruction Per Byte". Three table lookups on the nibbles
+// of each byte and the one before it classify every two byte window, the
+// third and fourth bytes of longer sequences are checked against the lead
+// bytes two and three positions back.
+namespace utf8 {
+
+constexpr std::uint8_t too_short = 1 << 0;
+constexpr std::uint8_t too_long = 1 << 1;
+constexpr std::uint8_t overlong_3 = 1 << 2;
+constexpr std::uint8_t too_large = 1 << 3;
+constexpr std::uint8_t surrogate = 1 << 4;
+constexpr std::uint8_t overlong_2 = 1 << 5;
+constexpr std::uint8_t too_large_1000 = 1 << 6;
+constexpr std::uint8_t overlong_4 = 1 << 6;
+constexpr std::uint8_t two_conts = 1 << 7;
+constexpr std::uint8_t carry = too_short | too_long | two_conts;
+
+// indexed by the high nibble of the previous byte.
+constexpr std::array<std::uint8_t, 16> byte_1_high = {
+    too_long, too_long, too_long, too_long,
+    too_long, too_long, too_long, too_long,
+    two_conts, two_conts, two_conts, two_conts,
+    too_short | overlong_2,
+    too_short,
+    too_short | overlong_3 | surrogate,
+    too_short | too_large | too_large_1000 | overlong_4,
+};
+
+// indexed by the low nibble of the previous byte.
+constexpr std::array<std::uint8_t, 16> byte_1_low = {
+    carry | overlong_3 | overlong_2 | overlong_4,
+    carry | overlong_2,
+    carry,
+    carry,
+    carry | too_large,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000 | surrogate,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+};
+
+// indexed by the high nibble of the current byte.
+constexpr std::array<std::uint8_t, 16> byte_2_high = {
+    too_short, too_short, too_short, too_short,
+    too_short, too_short, too_short, too_short,
+    too_long | overlong_2 | two_conts | overlong_3 | too_large_1000 | overlong_4,
+    too_long | overlong_2 | two_conts | overlong_3 | too_large,
+    too_long | overlong_2 | two_conts | surrogate | too_large,
+    too_long | overlong_2 | two_conts | surrogate | too_large,
+    too_short, too_short, too_short, too_short,
+};
+
+__attribute__((target("avx2")))
+auto lookup(const std::array<std::uint8_t, 16>& table, __m256i index) -> __m256i {
+    const auto lane = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table.data()));
+
+    return _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(lane), index);
+}
+
+__attribute__((target("avx2")))
+auto high_nibbles(__m256i bytes) -> __m256i {
+    return _mm256_and_si256(_mm256_srli_epi16(bytes, 4), _mm256_set1_epi8(0x0f));
+}
+
+// bytes shifted by n, the first n coming from the end of previous.
+template <int N>
+__attribute__((target("avx2")))
+auto previous(__m256i input, __m256i previous) -> __m256i {
+    return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - N);
+}
+
+__attribute__((target("avx2")))
+auto check_block(__m256i input, __m256i previous_input) -> __m256i {
+    const auto prev1 = previous<1>(input, previous_input);
+
+    const auto special_cases = _mm256_and_si256(
+            _mm256_and_si256(lookup(byte_1_high, high_nibbles(prev1)), lookup(byte_1_low, _mm256_and_si256(prev1, _mm256_set1_epi8(0x0f)))),
+            lookup(byte_2_high, high_nibbles(input)));
+
+    // a third or fourth byte has to be a continuation, which is exactly
+    // the case two_conts flagged above.
+    const auto third = _mm256_subs_epu8(previous<2>(input, previous_input), _mm256_set1_epi8(static_cast<char>(0xe0 - 0x80)));
+    const auto fourth = _mm256_subs_epu8(previous<3>(input, previous_input), _mm256_set1_epi8(static_cast<char>(0xf0 - 0x80)));
+    const auto must_be_continuation = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+
+    return _mm256_xor_si256(must_be_continuation, special_cases);
+}
+
+// non-zero where the block ends inside a sequence.
+__attribute__((target("avx2")))
+auto incomplete(__m256i input) -> __m256i {
+    const auto max = _mm256_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            static_cast<char>(0xf0 - 1), static_cast<char>(0xe0 - 1), static_cast<char>(0xc0 - 1));
+
+    return _mm256_subs_epu8(input, max);
+}
+
+}
+
+__attribute__((target("avx2")))
+auto validate_utf8_avx2(std::string_view text) -> bool {
+    auto error = _mm256_setzero_si256();
+    auto previous_input = _mm256_setzero_si256();
+    auto previous_incomplete = _mm256_setzero_si256();
+
+    for (std::size_t base = 0; base < text.length(); base += block_size) {
+        __m256i input;
+
+        if (text.length() - base >= block_size) {
+            input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + base));
+        } else {
+            // zeros are ascii, a sequence cut short by the end still fails.
+            char tail[block_size] = {};
+
+            std::memcpy(tail, text.data() + base, text.length() - base);
+
+            input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tail));
+        }
+
+        if (_mm256_movemask_epi8(input) == 0) {
+            error = _mm256_or_si256(error, previous_incomplete);
+            previous_input = _mm256_setzero_si256();
+            previous_incomplete = _mm256_setzero_si256();
+            continue;
+        }
+
+        error = _mm256_or_si256(error, utf8::check_block(input, previous_input));
+
+        previous_input = input;
+        previous_incomplete = utf8::incomplete(input);
+    }
+
+    error = _mm256_or_si256(error, previous_incomplete);
+
+    return _mm256_testz_si256(error, error);
+}
+
+#endif
+
+}
+
+auto parse_unicode_escape(std::string_view text) -> int {
+    if (text.length() < 6 or text[0] != '\\' or text[1] != 'u')
+        return -1;
+
+    int result = 0;
+
+    for (std::size_t i = 2; i < 6; i++) {
+        const auto digit = hex_value(text[i]);
+
+        if (digit < 0)
+            return -1;
+
+        result = result * 16 + digit;
+    }
+
+    return result;
+}
+
+auto is_high_surrogate(int unit) -> bool {
+    return unit >= 0xd800 and unit <= 0xdbff;
+}
+
+auto is_low_surrogate(int unit) -> bool {
+    return unit >= 0xdc00 and unit <= 0xdfff;
+}
+
+auto utf8_sequence_length(std::string_view text) -> std::size_t {
+    const auto byte_at = [text](std::size_t i) -> unsigned {
+        return i < text.length() ? static_cast<unsigned char>(text[i]) : 0;
+    };
+
+    const auto lead = byte_at(0);
+
+    std::size_t length = 0;
+    unsigned low = 0x80;
+    unsigned high = 0xbf;
+
+    if (lead >= 0xc2 and lead <= 0xdf) {
+        length = 2;
+    } else if (lead >= 0xe0 and lead <= 0xef) {
+        length = 3;
+
+        if (lead == 0xe0)
+            low = 0xa0;
+        else if (lead == 0xed)
+            high = 0x9f;
+    } else if (lead >= 0xf0 and lead <= 0xf4) {
+        length = 4;
+
+        if (lead == 0xf0)
+            low = 0x90;
+        else if (lead == 0xf4)
+            high = 0x8f;
+    } else {
+        return 0;
+    }
+
+    // only the second byte has a narrower range.
+    if (byte_at(1) < low or byte_at(1) > high)
+        return 0;
+
+    for (std::size_t i = 2; i < length; i++) {
+        if (byte_at(i) < 0x80 or byte_at(i) > 0xbf)
+            return 0;
+    }
+
+    return length;
+}
+
+auto escape_length(std::string_view rest) -> std::size_t {
+    if (rest.length() < 2)
+        return 0;
+
+    switch (rest[1]) {
+    case '"':
+    case '\\':
+    case '/':
+    case 'b':
+    case 'f':
+    case 'n':
+    case 'r':
+    case 't':
+        return 2;
+    case 'u':
+        break;
+    default:
+        return 0;
+    }
+
+    const auto unit = parse_unicode_escape(rest);
+
+    if (unit < 0 or is_low_surrogate(unit))
+        return 0;
+
+    if (not is_high_surrogate(unit))
+        return 6;
+
+    if (not is_low_surrogate(parse_unicode_escape(rest.substr(6))))
+        return 0;
+
+    return 12;
+}
+
+auto scan_string_literal(std::string_view input) -> StringScan {
+    return scan_string_literal(input, detect_simd_level());
+}
+
+auto scan_string_literal(std::string_view input, SimdLevel level) -> StringScan {
+    const auto classify = select_classifier(level);
+
+    StringScan result{std::string_view::npos, false, false, false, false};
+
+    std::size_t position = 0;
+
+    while (position < input.length()) {
+        const auto remaining = input.length() - position;
+
+        StringMasks masks;
+
+        if (remaining >= block_size) {
+            masks = classify(input.data() + position);
+        } else {
+            // padded with spaces, which neither end the string nor count.
+            char tail[block_size];
+
+            std::memset(tail, ' ', block_size);
+            std::memcpy(tail, input.data() + position, remaining);
+
+            masks = classify(tail);
+        }
+
+        const auto stops = masks.quote | masks.backslash;
+
+        // bytes before the first quote or backslash are plain content.
+        const auto end = stops == 0 ? block_size : static_cast<std::size_t>(__builtin_ctz(stops));
+        const auto before = end == block_size ? ~std::uint32_t{0} : (std::uint32_t{1} << end) - 1;
+
+        result.has_non_ascii |= (masks.non_ascii & before) != 0;
+        result.has_control |= (masks.control & before) != 0;
+
+        if (stops == 0) {
+            position += block_size;
+            continue;
+        }
+
+        if (masks.quote & (std::uint32_t{1} << end)) {
+            result.length = position + end;
+            break;
+        }
+
+        // the escape is checked right here, the scan already stopped on it.
+        // a broken one only skips the escaped character, so a quote after
+        // "\\u" still ends the string.
+        const auto length = escape_length(input.substr(position + end));
+
+        result.has_escapes = true;
+        result.has_invalid_escape |= length == 0;
+        position += end + (length == 0 ? 2 : length);
+    }
+
+    return result;
+}
+
+auto check_escapes(std::string_view literal) -> bool {
+    auto position = literal.find('\\');
+
+    while (position != std::string_view::npos) {
+        const auto length = escape_length(literal.substr(position));
+
+        if (length == 0)
+            return false;
+
+        position = literal.find('\\', position + length);
+    }
+
+    return true;
+}
+
+auto unescape_string(std::string_view literal, std::string& out) -> void {
+    out.reserve(out.length() + literal.length());
+
+    while (not literal.empty()) {
+        const auto backslash = literal.find('\\');
+
+        out.append(literal.substr(0, backslash));
+
+        if (backslash == std::string_view::npos)
+            return;
+
+        literal.remove_prefix(backslash);
+
+        std::size_t length = 2;
+
+        switch (literal[1]) {
+        case 'b':
+            out.push_back('\b');
+            break;
+        case 'f':
+            out.push_back('\f');
+            break;
+        case 'n':
+            out.push_back('\n');
+            break;
+        case 'r':
+            out.push_back('\r');
+            break;
+        case 't':
+            out.push_back('\t');
+            break;
+        case 'u': {
+            auto code_point = static_cast<std::uint32_t>(parse_unicode_escape(literal));
+
+            length = 6;
+
+            if (is_high_surrogate(static_cast<int>(code_point))) {
+                const auto low = static_cast<std::uint32_t>(parse_unicode_escape(literal.substr(6)));
+
+                code_point = 0x10000 + ((code_point - 0xd800) << 10) + (low - 0xdc00);
+                length = 12;
+            }
+
+            append_utf8(out, code_point);
+            break;
+        }
+        default:
+            // '"', '\\' and '/' stand for themselves.
+            out.push_back(literal[1]);
+            break;
+        }
+
+        literal.remove_prefix(length);
+    }
+}
+
+auto validate_utf8(std::string_view text) -> bool {
+    return validate_utf8(text, detect_simd_level());
+}
+
+auto validate_utf8(std::string_view text, SimdLevel level) -> bool {
+#if defined(__x86_64__)
+    if (level >= SimdLevel::Avx2 and detect_simd_level() >= SimdLevel::Avx2)
+        return validate_utf8_avx2(text);
+#endif
+
+    return validate_utf8_sequences(text, level);
+}
+
+auto find_escape(std::string_view text, bool ascii_only) -> std::size_t {
+    return find_escape(text, ascii_only, detect_simd_level());
+}
+
+auto find_escape(std::string_view text, bool ascii_only, SimdLevel level) -> std::size_t {
+    const auto classify = select_classifier(level);
+
+    const auto needs_escape = [ascii_only](const StringMasks& masks) {
+        return masks.quote | masks.backslash | masks.control | (ascii_only ? masks.non_ascii : 0);
+    };
+
+    std::size_t position = 0;
+
+    while (position + block_size <= text.length()) {
+        const auto found = needs_escape(classify(text.data() + position));
+
+        if (found != 0)
+            return position + static_cast<std::size_t>(__builtin_ctz(found));
+
+        position += block_size;
+    }
+
+    if (position == text.length())
+        return position;
+
+    // the last block overlaps the one before it instead of being copied into
+    // padding, the bytes already looked at are masked off.
+    if (text.length() >= block_size) {
+        const auto start = text.length() - block_size;
+        const auto found = needs_escape(classify(text.data() + start)) >> (position - start);
+
+        if (found != 0)
+            return position + static_cast<std::size_t>(__builtin_ctz(found));
+
+        return text.length();
+    }
+
+    // shorter than a block, short keys mostly.
+    for (; position < text.length(); position++) {
+        const auto byte = static_cast<unsigned char>(text[position]);
+
+        if (byte < 0x20 or byte == '"' or byte == '\\' or (ascii_only and byte >= 0x80))
+            return position;
+    }
+
+    return position;
+}
+
+auto decode_utf8(std::string_view text, std::uint32_t& code_point) -> std::size_t {
+    const auto length = utf8_sequence_length(text);
+
+    if (length == 0)
+        return 0;
+
+    static constexpr std::uint32_t lead_mask[] = {0, 0, 0x1f, 0x0f, 0x07};
+
+    code_point = static_cast<unsigned char>(text[0]) & lead_mask[length];
+
+    for (std::size_t i = 1; i < length; i++)
+        code_point = (code_point << 6) | (static_cast<unsigned char>(text[i]) & 0x3f);
+
+    return length;
+}
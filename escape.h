@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "simd.h"
+
+// What a single pass over a string literal found, up to its closing quote.
+struct StringScan {
+    // bytes before the closing quote, npos if the input ends first.
+    std::size_t length;
+
+    bool has_escapes;
+
+    // some escape sequence is not one json knows, or a surrogate escape is
+    // missing its other half.
+    bool has_invalid_escape;
+
+    bool has_non_ascii;
+
+    // raw bytes below 0x20, which json does not allow inside strings.
+    bool has_control;
+};
+
+// Finds the end of the string literal input starts with, just past its
+// opening quote. Escaped quotes do not end it. Looks at 32 bytes at a time
+// and only stops at backslashes, which are checked on the spot, the other
+// flags come for free along the way.
+auto scan_string_literal(std::string_view input) -> StringScan;
+
+// scan with a specific instruction set, clamped to what the cpu supports.
+auto scan_string_literal(std::string_view input, SimdLevel level) -> StringScan;
+
+// The code unit of the "\uXXXX" text starts with, or -1.
+auto parse_unicode_escape(std::string_view text) -> int;
+
+auto is_high_surrogate(int unit) -> bool;
+
+auto is_low_surrogate(int unit) -> bool;
+
+// Length of the escape sequence rest starts with, backslash included, a
+// surrogate pair counting as one. Zero if it is not a valid one.
+auto escape_length(std::string_view rest) -> std::size_t;
+
+// Length of the well formed multi byte utf-8 sequence text starts with,
+// zero if there is none.
+auto utf8_sequence_length(std::string_view text) -> std::size_t;
+
+// Every backslash in literal starts one of the json escape sequences, and
+// surrogate escapes come in high/low pairs.
+auto check_escapes(std::string_view literal) -> bool;
+
+// Appends literal to out with its escape sequences decoded, \u escapes as
+// utf-8. Runs without escapes are copied in bulk. literal has to pass
+// check_escapes.
+auto unescape_string(std::string_view literal, std::string& out) -> void;
+
+// Well formed utf-8: no overlong forms, no encoded surrogates, nothing past
+// U+10FFFF and no truncated sequences. With avx2 the whole check is
+// vectorized, otherwise only runs of ascii are skipped in bulk.
+auto validate_utf8(std::string_view text) -> bool;
+
+auto validate_utf8(std::string_view text, SimdLevel level) -> bool;
+
+// Offset of the first byte of text that cannot go into a json string as is:
+// quotes, backslashes and control characters, and with ascii_only every byte
+// from 0x80 up. text.length() if there is none. Clean runs are checked 32
+// bytes at a time, so a string that needs nothing costs about a memcpy.
+auto find_escape(std::string_view text, bool ascii_only) -> std::size_t;
+
+auto find_escape(std::string_view text, bool ascii_only, SimdLevel level) -> std::size_t;
+
+// Decodes the well formed multi byte sequence text starts with into
+// code_point and returns its length, or zero if it is not one.
+auto decode_utf8(std::string_view text, std::uint32_t& code_point) -> std::size_t;
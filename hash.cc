@@ -0,0 +1,48 @@
+#include <bit>
+#include <cstring>
+
+#include "hash.h"
+
+namespace {
+
+constexpr std::uint64_t prime_1 = 0x9e3779b185ebca87;
+constexpr std::uint64_t prime_2 = 0xc2b2ae3d27d4eb4f;
+
+auto load_word(const char* data) -> std::uint64_t {
+    std::uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+
+    return word;
+}
+
+auto mix(std::uint64_t lane, std::uint64_t word) -> std::uint64_t {
+    return std::rotl(lane + word * prime_2, 31) * prime_1;
+}
+
+}
+
+auto hash_bytes(std::string_view data, std::uint64_t seed) -> std::uint64_t {
+    std::uint64_t lanes[4] = {seed + prime_1 + prime_2, seed + prime_2, seed, seed - prime_1};
+    std::size_t i = 0;
+
+    for (; i + 32 <= data.length(); i += 32) {
+        for (std::size_t lane = 0; lane < 4; lane++)
+            lanes[lane] = mix(lanes[lane], load_word(data.data() + i + lane * 8));
+    }
+
+    auto hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+
+    hash += data.length();
+
+    for (; i + 8 <= data.length(); i += 8)
+        hash = std::rotl(hash ^ mix(0, load_word(data.data() + i)), 27) * prime_1;
+
+    for (; i < data.length(); i++)
+        hash = std::rotl(hash ^ (static_cast<unsigned char>(data[i]) * prime_1), 11) * prime_2;
+
+    hash ^= hash >> 33;
+    hash *= prime_2;
+    hash ^= hash >> 29;
+
+    return hash;
+}
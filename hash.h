@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+// Fast non-cryptographic 64-bit hash of a byte string, after xxhash64: four
+// independent lanes of multiply and rotate over 8 byte words, so it runs at
+// about memory speed. Good for checksums and cache keys, not against an
+// adversary.
+auto hash_bytes(std::string_view data, std::uint64_t seed = 0) -> std::uint64_t;
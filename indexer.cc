@@ -0,0 +1,229 @@
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "indexer.h"
+#include "stats.h"
+
+namespace {
+
+constexpr std::size_t block_size = 64;
+
+struct BlockMasks {
+    std::uint64_t backslash;
+    std::uint64_t quote;
+    std::uint64_t whitespace;
+    std::uint64_t op;
+};
+
+using ClassifyBlock = auto (*)(const char*) -> BlockMasks;
+
+auto is_json_whitespace(char c) -> bool {
+    return c == ' ' or c == '\t' or c == '\n' or c == '\r';
+}
+
+auto is_json_op(char c) -> bool {
+    return c == '{' or c == '}' or c == '[' or c == ']' or c == ':' or c == ',';
+}
+
+auto classify_scalar(const char* block) -> BlockMasks {
+    BlockMasks masks{};
+
+    for (std::size_t i = 0; i < block_size; i++) {
+        const auto bit = std::uint64_t{1} << i;
+
+        if (block[i] == '\\')
+            masks.backslash |= bit;
+        else if (block[i] == '"')
+            masks.quote |= bit;
+        else if (is_json_whitespace(block[i]))
+            masks.whitespace |= bit;
+        else if (is_json_op(block[i]))
+            masks.op |= bit;
+    }
+
+    return masks;
+}
+
+#if defined(__x86_64__)
+
+auto classify_sse2(const char* block) -> BlockMasks {
+    BlockMasks masks{};
+
+    for (std::size_t i = 0; i < block_size; i += 16) {
+        const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+        const auto eq = [&chunk](char c) {
+            return _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c));
+        };
+        const auto bits = [](__m128i mask) {
+            return static_cast<std::uint64_t>(static_cast<std::uint16_t>(_mm_movemask_epi8(mask)));
+        };
+
+        const auto whitespace = _mm_or_si128(_mm_or_si128(eq(' '), eq('\t')), _mm_or_si128(eq('\n'), eq('\r')));
+        const auto op = _mm_or_si128(
+                _mm_or_si128(_mm_or_si128(eq('{'), eq('}')), _mm_or_si128(eq('['), eq(']'))),
+                _mm_or_si128(eq(':'), eq(',')));
+
+        masks.backslash |= bits(eq('\\')) << i;
+        masks.quote |= bits(eq('"')) << i;
+        masks.whitespace |= bits(whitespace) << i;
+        masks.op |= bits(op) << i;
+    }
+
+    return masks;
+}
+
+__attribute__((target("avx2")))
+auto classify_avx2(const char* block) -> BlockMasks {
+    BlockMasks masks{};
+
+    for (std::size_t i = 0; i < block_size; i += 32) {
+        const auto chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+        const auto eq = [&chunk](char c) __attribute__((target("avx2"))) {
+            return _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(c));
+        };
+        const auto bits = [](__m256i mask) __attribute__((target("avx2"))) {
+            return static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(mask)));
+        };
+
+        const auto whitespace = _mm256_or_si256(_mm256_or_si256(eq(' '), eq('\t')), _mm256_or_si256(eq('\n'), eq('\r')));
+        const auto op = _mm256_or_si256(
+                _mm256_or_si256(_mm256_or_si256(eq('{'), eq('}')), _mm256_or_si256(eq('['), eq(']'))),
+                _mm256_or_si256(eq(':'), eq(',')));
+
+        masks.backslash |= bits(eq('\\')) << i;
+        masks.quote |= bits(eq('"')) << i;
+        masks.whitespace |= bits(whitespace) << i;
+        masks.op |= bits(op) << i;
+    }
+
+    return masks;
+}
+
+#endif
+
+auto select_classifier(SimdLevel level) -> ClassifyBlock {
+#if defined(__x86_64__)
+    if (level > detect_simd_level())
+        level = detect_simd_level();
+
+    switch (level) {
+    case SimdLevel::Avx2:
+        return classify_avx2;
+    case SimdLevel::Sse2:
+        return classify_sse2;
+    case SimdLevel::Scalar:
+        break;
+    }
+#else
+    (void)level;
+#endif
+
+    return classify_scalar;
+}
+
+// bits of the characters preceded by an odd number of backslashes. backslashes
+// are rare, so walking them one by one is cheaper than the branchless version.
+auto find_escaped(std::uint64_t backslash, bool& prev_escaped) -> std::uint64_t {
+    std::uint64_t escaped = prev_escaped ? 1 : 0;
+
+    prev_escaped = false;
+
+    while (backslash != 0) {
+        const auto i = __builtin_ctzll(backslash);
+        const auto bit = std::uint64_t{1} << i;
+
+        backslash &= backslash - 1;
+
+        if (escaped & bit)
+            continue;
+
+        if (i == 63)
+            prev_escaped = true;
+        else
+            escaped |= bit << 1;
+    }
+
+    return escaped;
+}
+
+// bit i becomes the parity of the quotes at or before i.
+auto prefix_xor(std::uint64_t bits) -> std::uint64_t {
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+
+    return bits;
+}
+
+}
+
+auto StructuralIndex::build(std::string_view input) -> StructuralIndex {
+    return build(input, detect_simd_level());
+}
+
+auto StructuralIndex::build(std::string_view input, SimdLevel level) -> StructuralIndex {
+    JSON_PHASE(JsonPhase::Index);
+
+    StructuralIndex index;
+
+    const auto classify = select_classifier(level);
+
+    // a rough guess, most documents have a structural every 4 to 8 bytes.
+    index.m_positions.reserve(input.length() / 4 + 16);
+
+    bool prev_escaped = false;
+    std::uint64_t prev_in_string = 0;
+    std::uint64_t prev_scalar = 0;
+
+    for (std::size_t base = 0; base < input.length(); base += block_size) {
+        const auto remaining = input.length() - base;
+
+        BlockMasks masks;
+
+        if (remaining >= block_size) {
+            masks = classify(input.data() + base);
+        } else {
+            // the last block is padded with whitespace so nothing is read past the end.
+            char tail[block_size];
+
+            std::memset(tail, ' ', block_size);
+            std::memcpy(tail, input.data() + base, remaining);
+
+            masks = classify(tail);
+        }
+
+        const auto escaped = find_escaped(masks.backslash, prev_escaped);
+        const auto quote = masks.quote & ~escaped;
+
+        // opening quotes and string contents are set, closing quotes are not.
+        const auto in_string = prefix_xor(quote) ^ prev_in_string;
+        prev_in_string = static_cast<std::uint64_t>(static_cast<std::int64_t>(in_string) >> 63);
+
+        const auto scalar = ~(masks.op | masks.whitespace | quote) & ~in_string;
+        const auto scalar_start = scalar & ~((scalar << 1) | prev_scalar);
+        prev_scalar = scalar >> 63;
+
+        auto structurals = (masks.op & ~in_string) | (quote & in_string) | scalar_start;
+
+        while (structurals != 0) {
+            index.m_positions.push_back(static_cast<std::uint32_t>(base + __builtin_ctzll(structurals)));
+            structurals &= structurals - 1;
+        }
+    }
+
+    return index;
+}
+
+auto StructuralIndex::positions() const -> const std::vector<std::uint32_t>& {
+    return m_positions;
+}
+
+auto StructuralIndex::size() const -> std::size_t {
+    return m_positions.size();
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+#include "simd.h"
+
+// Stage-1 pass over a document: the byte offsets of every structural
+// character ({ } [ ] : ,) outside of strings, every opening quote and the
+// first byte of every bare scalar (numbers, true, false, null, garbage).
+// JsonLexer can walk these offsets instead of skipping whitespace itself.
+class StructuralIndex {
+public:
+    // offsets are stored as 32 bits, larger inputs have to be lexed directly.
+    static constexpr std::size_t max_input_size = std::numeric_limits<std::uint32_t>::max();
+
+    static auto build(std::string_view input) -> StructuralIndex;
+
+    // build with a specific instruction set, clamped to what the cpu supports.
+    static auto build(std::string_view input, SimdLevel level) -> StructuralIndex;
+
+    auto positions() const -> const std::vector<std::uint32_t>&;
+
+    auto size() const -> std::size_t;
+
+private:
+    std::vector<std::uint32_t> m_positions;
+};
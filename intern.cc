@@ -0,0 +1,118 @@
+#include <functional>
+
+#include "intern.h"
+
+namespace {
+
+constexpr std::size_t initial_capacity = 64;
+
+auto hash_string(std::string_view string) -> std::size_t {
+    return std::hash<std::string_view>{}(string);
+}
+
+}
+
+StringTable::StringTable() {
+    for (auto& shard : m_shards) {
+        shard.tables.push_back(std::make_unique<Slots>(initial_capacity));
+        shard.slots.store(shard.tables.back().get(), std::memory_order_release);
+    }
+}
+
+StringTable::~StringTable() = default;
+
+auto StringTable::shared() -> StringTable& {
+    // leaked on purpose, interned keys may be used during static destruction.
+    static auto* table = new StringTable();
+
+    return *table;
+}
+
+auto StringTable::intern(std::string_view string) -> const std::string* {
+    const auto hash = hash_string(string);
+
+    auto& shard = shard_for(hash);
+
+    if (const auto* found = probe(*shard.slots.load(std::memory_order_acquire), hash, string))
+        return found;
+
+    std::lock_guard lock(shard.mutex);
+
+    // somebody may have inserted it between the lookup and the lock.
+    auto* slots = shard.slots.load(std::memory_order_relaxed);
+
+    if (const auto* found = probe(*slots, hash, string))
+        return found;
+
+    // keep the table at most half full, so probe sequences stay short.
+    if ((shard.entries.size() + 1) * 2 > slots->capacity) {
+        auto grown = std::make_unique<Slots>(slots->capacity * 2);
+
+        for (const auto& entry : shard.entries)
+            insert_slot(*grown, entry);
+
+        slots = grown.get();
+
+        // the old table stays alive, readers may still be probing it.
+        shard.tables.push_back(std::move(grown));
+        shard.slots.store(slots, std::memory_order_release);
+    }
+
+    const auto& entry = shard.entries.emplace_back(Entry{hash, std::string(string)});
+
+    insert_slot(*slots, entry);
+
+    return &entry.string;
+}
+
+auto StringTable::find(std::string_view string) const -> const std::string* {
+    const auto hash = hash_string(string);
+
+    return probe(*shard_for(hash).slots.load(std::memory_order_acquire), hash, string);
+}
+
+auto StringTable::size() const -> std::size_t {
+    std::size_t result = 0;
+
+    for (auto& shard : m_shards) {
+        std::lock_guard lock(shard.mutex);
+
+        result += shard.entries.size();
+    }
+
+    return result;
+}
+
+auto StringTable::probe(const Slots& slots, std::size_t hash, std::string_view string) -> const std::string* {
+    const auto mask = slots.capacity - 1;
+
+    for (auto slot = hash & mask;; slot = (slot + 1) & mask) {
+        const auto* entry = slots.entries[slot].load(std::memory_order_acquire);
+
+        if (not entry)
+            return nullptr;
+
+        if (entry->hash == hash and entry->string == string)
+            return &entry->string;
+    }
+}
+
+auto StringTable::insert_slot(Slots& slots, const Entry& entry) -> void {
+    const auto mask = slots.capacity - 1;
+
+    auto slot = entry.hash & mask;
+
+    while (slots.entries[slot].load(std::memory_order_relaxed))
+        slot = (slot + 1) & mask;
+
+    slots.entries[slot].store(&entry, std::memory_order_release);
+}
+
+auto StringTable::shard_for(std::size_t hash) const -> const Shard& {
+    // the low bits pick the slot, the high bits the shard.
+    return m_shards[(hash >> 56) % shard_count];
+}
+
+auto StringTable::shard_for(std::size_t hash) -> Shard& {
+    return m_shards[(hash >> 56) % shard_count];
+}
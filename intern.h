@@ -0,0 +1,137 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Thread safe set of immutable strings. Every distinct string is stored once
+// and interned pointers stay valid for the lifetime of the table, so two
+// strings from the same table are equal exactly when their pointers are.
+//
+// Lookups never take a lock: each shard publishes an open addressing table
+// through an atomic pointer. Inserts lock only their shard, and a shard
+// that grows keeps its old table alive for readers that may still be
+// walking it.
+class StringTable {
+public:
+    static constexpr std::size_t shard_count = 16;
+
+    StringTable();
+
+    StringTable(const StringTable& other) = delete;
+
+    auto operator=(const StringTable& other) -> StringTable& = delete;
+
+    ~StringTable();
+
+    // process wide table, never destroyed.
+    static auto shared() -> StringTable&;
+
+    auto intern(std::string_view string) -> const std::string*;
+
+    // nullptr if the string was never interned.
+    auto find(std::string_view string) const -> const std::string*;
+
+    auto size() const -> std::size_t;
+
+private:
+    struct Entry {
+        std::size_t hash;
+        std::string string;
+    };
+
+    struct Slots {
+        explicit Slots(std::size_t capacity)
+            : capacity(capacity), entries(new std::atomic<const Entry*>[capacity]()) {}
+
+        std::size_t capacity;
+        std::unique_ptr<std::atomic<const Entry*>[]> entries;
+    };
+
+    struct Shard {
+        std::atomic<Slots*> slots{nullptr};
+
+        mutable std::mutex mutex;
+        std::deque<Entry> entries;
+        std::vector<std::unique_ptr<Slots>> tables;
+    };
+
+    static auto probe(const Slots& slots, std::size_t hash, std::string_view string) -> const std::string*;
+
+    static auto insert_slot(Slots& slots, const Entry& entry) -> void;
+
+    auto shard_for(std::size_t hash) const -> const Shard&;
+
+    auto shard_for(std::size_t hash) -> Shard&;
+
+private:
+    std::array<Shard, shard_count> m_shards;
+};
+
+// An object key, either an owned string or a string interned in a
+// StringTable. Interned keys are shared between documents and cost no
+// allocation.
+class JsonKey {
+public:
+    JsonKey() = default;
+
+    JsonKey(std::string key)
+        : m_owned(std::move(key)) {}
+
+    JsonKey(std::string_view key)
+        : m_owned(key) {}
+
+    JsonKey(const char* key)
+        : m_owned(key) {}
+
+    // the table has to outlive the key.
+    static auto interned(const std::string* key) -> JsonKey {
+        JsonKey result;
+
+        result.m_interned = key;
+
+        return result;
+    }
+
+    auto view() const -> std::string_view {
+        return m_interned ? std::string_view(*m_interned) : std::string_view(m_owned);
+    }
+
+    auto is_interned() const -> bool {
+        return m_interned != nullptr;
+    }
+
+    // the string in its table, nullptr for owned keys.
+    auto interned_string() const -> const std::string* {
+        return m_interned;
+    }
+
+    friend auto operator==(const JsonKey& lhs, const JsonKey& rhs) -> bool {
+        if (lhs.m_interned and lhs.m_interned == rhs.m_interned)
+            return true;
+
+        return lhs.view() == rhs.view();
+    }
+
+    friend auto operator==(const JsonKey& lhs, std::string_view rhs) -> bool {
+        return lhs.view() == rhs;
+    }
+
+    friend auto operator==(const JsonKey& lhs, const std::string& rhs) -> bool {
+        return lhs.view() == rhs;
+    }
+
+    friend auto operator==(const JsonKey& lhs, const char* rhs) -> bool {
+        return lhs.view() == rhs;
+    }
+
+private:
+    std::string m_owned;
+    const std::string* m_interned{nullptr};
+};
@@ -1,7 +1,37 @@
 #include "jsonval.h"
+#include "stats.h"
+
+auto value_type_to_string(JsonValueType type) -> std::string_view {
+    switch (type) {
+    case JsonValueType::JsonBool:
+        return "boolean";
+    case JsonValueType::JsonNumber:
+        return "number";
+    case JsonValueType::JsonString:
+        return "string";
+    case JsonValueType::JsonObject:
+        return "object";
+    case JsonValueType::JsonArray:
+        return "array";
+    case JsonValueType::JsonNull:
+        return "null";
+    }
+
+    return "unknown";
+}
+
+auto JsonValue::serialize(const JsonWriterOptions& options) const -> std::string {
+    JSON_PHASE(JsonPhase::Serialize);
+
+    JsonWriter writer(options);
+
+    write(writer);
 
-auto JsonBool::serialize() const -> std::string {
-    return m_boolean ? "true" : "false";
+    return writer.take();
+}
+
+auto JsonBool::write(JsonWriter& writer) const -> void {
+    writer.write_bool(m_boolean);
 }
 
 auto JsonBool::get_type() const -> JsonValueType {
@@ -12,8 +42,17 @@ auto JsonBool::access(std::function<void(bool&)> func) -> void {
     func(m_boolean);
 }
 
-auto JsonNumber::serialize() const -> std::string {
-    return std::to_string(m_number);
+auto JsonBool::access(std::function<void(const bool&)> func) const -> void {
+    func(m_boolean);
+}
+
+auto JsonNumber::write(JsonWriter& writer) const -> void {
+    if (const auto* number = std::get_if<std::int64_t>(&m_number))
+        writer.write_int64(*number);
+    else if (const auto* number = std::get_if<std::uint64_t>(&m_number))
+        writer.write_uint64(*number);
+    else
+        writer.write_number(std::get<double>(m_number));
 }
 
 auto JsonNumber::get_type() const -> JsonValueType {
@@ -21,48 +60,90 @@ auto JsonNumber::get_type() const -> JsonValueType {
 }
 
 auto JsonNumber::access(std::function<void(double&)> func) -> void {
-    func(m_number);
+    const auto before = as_double();
+    auto number = before;
+
+    func(number);
+
+    if (number != before or std::holds_alternative<double>(m_number))
+        m_number = number;
+}
+
+auto JsonNumber::access(std::function<void(const double&)> func) const -> void {
+    func(as_double());
+}
+
+auto JsonNumber::value() const -> const NumberValue& {
+    return m_number;
+}
+
+auto JsonNumber::is_integer() const -> bool {
+    return not std::holds_alternative<double>(m_number);
+}
+
+auto JsonNumber::as_double() const -> double {
+    return std::visit([](auto number) { return static_cast<double>(number); }, m_number);
+}
+
+auto JsonNumber::as_int64() const -> std::optional<std::int64_t> {
+    if (const auto* number = std::get_if<std::int64_t>(&m_number))
+        return *number;
+
+    return std::nullopt;
 }
 
-auto JsonString::serialize() const -> std::string {
-    std::string result;
+auto JsonNumber::as_uint64() const -> std::optional<std::uint64_t> {
+    if (const auto* number = std::get_if<std::uint64_t>(&m_number))
+        return *number;
 
-    result.push_back('"');
-    result.append(m_string);
-    result.push_back('"');
+    if (const auto* number = std::get_if<std::int64_t>(&m_number); number and *number >= 0)
+        return static_cast<std::uint64_t>(*number);
+
+    return std::nullopt;
+}
+
+auto JsonString::interned(const std::string* string) -> JsonString {
+    JsonString result(std::string{});
+
+    result.m_interned = string;
 
     return result;
 }
 
+auto JsonString::write(JsonWriter& writer) const -> void {
+    writer.write_string(view());
+}
+
 auto JsonString::get_type() const -> JsonValueType {
     return JsonValueType::JsonString;
 }
 
 auto JsonString::access(std::function<void(std::string&)> func) -> void {
+    if (m_interned) {
+        m_string = *m_interned;
+        m_interned = nullptr;
+    }
+
     func(m_string);
 }
 
-auto JsonObject::serialize() const -> std::string {
-    std::string result;
+auto JsonString::access(std::function<void(const std::string&)> func) const -> void {
+    func(m_interned ? *m_interned : m_string);
+}
+
+auto JsonString::view() const -> std::string_view {
+    return m_interned ? std::string_view(*m_interned) : std::string_view(m_string);
+}
 
-    result.push_back('{');
+auto JsonObject::write(JsonWriter& writer) const -> void {
+    writer.start_object();
 
     for (const auto& [key, value] : m_dict) {
-        result.push_back('"');
-        result.append(key);
-        result.push_back('"');
-
-        result.push_back(':');
-        result.append(value->serialize());
-        result.push_back(',');
+        writer.write_key(key.view());
+        value->write(writer);
     }
 
-    if (m_dict.size() > 0)
-        result.pop_back();
-
-    result.push_back('}');
-
-    return result;
+    writer.end_object();
 }
 
 auto JsonObject::get_type() const -> JsonValueType {
@@ -73,22 +154,17 @@ auto JsonObject::access(std::function<void(JsonObjectDict&)> func) -> void {
     func(m_dict);
 }
 
-auto JsonArray::serialize() const -> std::string {
-    std::string result;
-
-    result.push_back('[');
-
-    for (const auto& elem : m_array) {
-        result.append(elem->serialize());
-        result.push_back(',');
-    }
+auto JsonObject::access(std::function<void(const JsonObjectDict&)> func) const -> void {
+    func(m_dict);
+}
 
-    if (m_array.size() > 0)
-        result.pop_back();
+auto JsonArray::write(JsonWriter& writer) const -> void {
+    writer.start_array();
 
-    result.push_back(']');
+    for (const auto& elem : m_array)
+        elem->write(writer);
 
-    return result;
+    writer.end_array();
 }
 
 auto JsonArray::get_type() const -> JsonValueType {
@@ -99,8 +175,12 @@ auto JsonArray::access(std::function<void(JsonArrayElements&)> func) -> void {
     func(m_array);
 }
 
-auto JsonNull::serialize() const -> std::string {
-    return "null";
+auto JsonArray::access(std::function<void(const JsonArrayElements&)> func) const -> void {
+    func(m_array);
+}
+
+auto JsonNull::write(JsonWriter& writer) const -> void {
+    writer.write_null();
 }
 
 auto JsonNull::get_type() const -> JsonValueType {
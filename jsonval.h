@@ -4,10 +4,16 @@
 #include <memory>
 #include <string>
 #include <tuple>
-#include <unordered_map>
 #include <vector>
 #include <initializer_list>
 #include <functional>
+#include <limits>
+#include <optional>
+#include <type_traits>
+
+#include "dict.h"
+#include "number.h"
+#include "writer.h"
 
 template <typename T>
 class ValueAccessor {
@@ -16,6 +22,8 @@ public:
 
     virtual auto access(std::function<void(T&)>) -> void = 0;
 
+    virtual auto access(std::function<void(const T&)>) const -> void = 0;
+
 protected:
     ValueAccessor() = default;
 };
@@ -29,11 +37,15 @@ enum class JsonValueType {
     JsonNull,
 };
 
+auto value_type_to_string(JsonValueType type) -> std::string_view;
+
 class JsonValue {
 public:
     virtual ~JsonValue() = default;
 
-    virtual auto serialize() const -> std::string = 0;
+    auto serialize(const JsonWriterOptions& options = {}) const -> std::string;
+
+    virtual auto write(JsonWriter& writer) const -> void = 0;
 
     virtual auto get_type() const -> JsonValueType = 0;
 
@@ -46,29 +58,61 @@ public:
     JsonBool(bool boolean)
         : m_boolean(boolean) {}
 
-    virtual auto serialize() const -> std::string override;
+    virtual auto write(JsonWriter& writer) const -> void override;
 
     virtual auto get_type() const -> JsonValueType override;
 
     virtual auto access(std::function<void(bool&)>) -> void override;
 
+    virtual auto access(std::function<void(const bool&)>) const -> void override;
+
 private:
     bool m_boolean;
 };
 
+// Integral literals keep their exact 64-bit value, so ids above 2^53 survive
+// a round trip. value() tells which representation is present.
 class JsonNumber : public JsonValue, ValueAccessor<double> {
 public:
     JsonNumber(double number)
         : m_number(number) {}
 
-    virtual auto serialize() const -> std::string override;
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T> and not std::is_same_v<T, bool>>>
+    JsonNumber(T number) {
+        if constexpr (std::is_signed_v<T>)
+            m_number = static_cast<std::int64_t>(number);
+        else if (static_cast<std::uint64_t>(number) <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()))
+            m_number = static_cast<std::int64_t>(number);
+        else
+            m_number = static_cast<std::uint64_t>(number);
+    }
+
+    JsonNumber(NumberValue number)
+        : m_number(number) {}
+
+    virtual auto write(JsonWriter& writer) const -> void override;
 
     virtual auto get_type() const -> JsonValueType override;
 
+    // the value as a double, rounding integers beyond 2^53. an integer keeps
+    // its representation unless the callback changes the value.
     virtual auto access(std::function<void(double&)>) -> void override;
 
+    virtual auto access(std::function<void(const double&)>) const -> void override;
+
+    auto value() const -> const NumberValue&;
+
+    auto is_integer() const -> bool;
+
+    auto as_double() const -> double;
+
+    // the exact value if it is an integer in range, nullopt otherwise.
+    auto as_int64() const -> std::optional<std::int64_t>;
+
+    auto as_uint64() const -> std::optional<std::uint64_t>;
+
 private:
-    double m_number;
+    NumberValue m_number;
 };
 
 class JsonString : public JsonValue, ValueAccessor<std::string> {
@@ -79,20 +123,28 @@ public:
     JsonString(const JsonString& other) = delete;
 
     JsonString(JsonString&& other)
-        : m_string(std::move(other.m_string)) {}
+        : m_string(std::move(other.m_string)), m_interned(other.m_interned) {}
+
+    // shares a string from a StringTable instead of owning a copy, the
+    // table has to outlive the value.
+    static auto interned(const std::string* string) -> JsonString;
 
-    virtual auto serialize() const -> std::string override;
+    virtual auto write(JsonWriter& writer) const -> void override;
 
     virtual auto get_type() const -> JsonValueType override;
 
+    // an interned string is copied out of the table before it can be changed.
     virtual auto access(std::function<void(std::string&)>) -> void override;
 
+    virtual auto access(std::function<void(const std::string&)>) const -> void override;
+
+    auto view() const -> std::string_view;
+
 private:
     std::string m_string;
+    const std::string* m_interned{nullptr};
 };
 
-using JsonObjectDict = std::unordered_map<std::string, std::shared_ptr<JsonValue>>;
-
 class JsonObject : public JsonValue, ValueAccessor<JsonObjectDict> {
 public:
     JsonObject(std::initializer_list<std::tuple<const char*, std::shared_ptr<JsonValue>>> list) {
@@ -100,17 +152,22 @@ public:
             m_dict[key] = value;
     }
 
+    JsonObject(JsonObjectDict dict)
+        : m_dict(std::move(dict)) {}
+
     JsonObject(const JsonObject& other) = delete;
 
     JsonObject(JsonObject&& other) 
         : m_dict(std::move(other.m_dict)) {}
 
-    virtual auto serialize() const -> std::string override;
+    virtual auto write(JsonWriter& writer) const -> void override;
 
     virtual auto get_type() const -> JsonValueType override;
 
     virtual auto access(std::function<void(JsonObjectDict&)>) -> void override;
 
+    virtual auto access(std::function<void(const JsonObjectDict&)>) const -> void override;
+
 private:
     JsonObjectDict m_dict;
 };
@@ -129,19 +186,21 @@ public:
     JsonArray(JsonArray&& other)
         : m_array(std::move(other.m_array)) {}
 
-    virtual auto serialize() const -> std::string override;
+    virtual auto write(JsonWriter& writer) const -> void override;
 
     virtual auto get_type() const -> JsonValueType override;
 
     virtual auto access(std::function<void(JsonArrayElements&)>) -> void override;
 
+    virtual auto access(std::function<void(const JsonArrayElements&)>) const -> void override;
+
 private:
     JsonArrayElements m_array;
 };
 
 class JsonNull : public JsonValue {
 public:
-    virtual auto serialize() const -> std::string override;
+    virtual auto write(JsonWriter& writer) const -> void override;
 
     virtual auto get_type() const -> JsonValueType override;
 };
@@ -0,0 +1,400 @@
+#include "escape.h"
+#include "lazy.h"
+#include "number.h"
+#include "sax.h"
+
+namespace {
+
+auto is_whitespace(char c) -> bool {
+    return c == ' ' or c == '\t' or c == '\n' or c == '\r';
+}
+
+auto skip_whitespaces(std::string_view input, std::size_t position) -> std::size_t {
+    while (position < input.length() and is_whitespace(input[position]))
+        position++;
+
+    return position;
+}
+
+auto error_at(std::string_view input, std::size_t position) -> JsonError {
+    if (position >= input.length())
+        return JsonError(JsonErrorCode::UnexpectedEndOfFile, input.length());
+
+    return JsonError(JsonErrorCode::UnexpectedCharacter, position, input.substr(position, 1));
+}
+
+auto expect_char(std::string_view input, std::size_t& position, char c) -> ErrorOr<std::monostate> {
+    if (position >= input.length() or input[position] != c)
+        return error_at(input, position);
+
+    position++;
+
+    return std::monostate{};
+}
+
+auto check_value_start(std::string_view input, std::size_t position) -> ErrorOr<std::monostate> {
+    if (position >= input.length())
+        return error_at(input, position);
+
+    switch (input[position]) {
+    case '{':
+    case '[':
+    case '"':
+    case 't':
+    case 'f':
+    case 'n':
+    case '-':
+        return std::monostate{};
+    default:
+        break;
+    }
+
+    if (input[position] >= '0' and input[position] <= '9')
+        return std::monostate{};
+
+    return error_at(input, position);
+}
+
+// position sits on the opening quote and ends up past the closing one.
+// returns the contents, escape sequences kept verbatim.
+auto scan_string(std::string_view input, std::size_t& position) -> ErrorOr<std::string_view> {
+    TRY(expect_char(input, position, '"'));
+
+    const auto start = position;
+
+    // only the end is needed here, the contents are checked when a value
+    // is parsed out of them.
+    const auto scan = scan_string_literal(input.substr(start));
+
+    if (scan.length == std::string_view::npos)
+        return error_at(input, input.length());
+
+    position += scan.length + 1;
+
+    return input.substr(start, scan.length);
+}
+
+// like scan_string, but for keys, which come back decoded. only a key with
+// escape sequences is copied, into scratch.
+auto scan_key(std::string_view input, std::size_t& position, std::string& scratch) -> ErrorOr<std::string_view> {
+    const auto start = position;
+    const auto key = TRY(scan_string(input, position));
+
+    if (key.find('\\') == std::string_view::npos)
+        return key;
+
+    if (not check_escapes(key))
+        return JsonError(JsonErrorCode::InvalidEscape, start, key);
+
+    scratch.clear();
+    unescape_string(key, scratch);
+
+    return std::string_view(scratch);
+}
+
+auto skip_literal(std::string_view input, std::size_t& position, std::string_view literal) -> ErrorOr<std::monostate> {
+    if (input.substr(position, literal.length()) != literal)
+        return error_at(input, position);
+
+    position += literal.length();
+
+    return std::monostate{};
+}
+
+// moves position past the value starting there. containers are skipped by
+// counting brackets, only strings need a closer look so that brackets
+// inside them do not count.
+auto skip_value(std::string_view input, std::size_t& position) -> ErrorOr<std::monostate> {
+    TRY(check_value_start(input, position));
+
+    switch (input[position]) {
+    case '"':
+        TRY(scan_string(input, position));
+        return std::monostate{};
+    case 't':
+        return skip_literal(input, position, "true");
+    case 'f':
+        return skip_literal(input, position, "false");
+    case 'n':
+        return skip_literal(input, position, "null");
+    case '{':
+    case '[':
+        break;
+    default: {
+        const auto length = scan_number(input.substr(position));
+
+        if (length == 0)
+            return error_at(input, position);
+
+        position += length;
+
+        return std::monostate{};
+    }
+    }
+
+    std::size_t depth = 0;
+
+    while (position < input.length()) {
+        switch (input[position]) {
+        case '"':
+            TRY(scan_string(input, position));
+            continue;
+        case '{':
+        case '[':
+            depth++;
+            break;
+        case '}':
+        case ']':
+            if (--depth == 0) {
+                position++;
+                return std::monostate{};
+            }
+            break;
+        default:
+            break;
+        }
+
+        position++;
+    }
+
+    return error_at(input, position);
+}
+
+// calls func(key, value) for each child of the container at offset, keys
+// are decoded and only valid during the call, empty for arrays. stops as
+// soon as func returns false, without looking at the rest of the container.
+template <typename Func>
+auto walk_container(std::string_view input, std::size_t offset, Func func) -> ErrorOr<std::monostate> {
+    const auto is_object = input[offset] == '{';
+    const auto close = is_object ? '}' : ']';
+
+    auto position = skip_whitespaces(input, offset + 1);
+
+    if (position < input.length() and input[position] == close)
+        return std::monostate{};
+
+    std::string scratch;
+
+    while (true) {
+        std::string_view key;
+
+        if (is_object) {
+            key = TRY(scan_key(input, position, scratch));
+
+            position = skip_whitespaces(input, position);
+
+            TRY(expect_char(input, position, ':'));
+
+            position = skip_whitespaces(input, position);
+        }
+
+        TRY(check_value_start(input, position));
+
+        if (not func(key, JsonLazyValue(input, position)))
+            return std::monostate{};
+
+        TRY(skip_value(input, position));
+
+        position = skip_whitespaces(input, position);
+
+        if (position < input.length() and input[position] == ',') {
+            position = skip_whitespaces(input, position + 1);
+            continue;
+        }
+
+        TRY(expect_char(input, position, close));
+
+        return std::monostate{};
+    }
+}
+
+}
+
+auto JsonLazyValue::get_type() const -> JsonValueType {
+    switch (m_input[m_offset]) {
+    case '{':
+        return JsonValueType::JsonObject;
+    case '[':
+        return JsonValueType::JsonArray;
+    case '"':
+        return JsonValueType::JsonString;
+    case 't':
+    case 'f':
+        return JsonValueType::JsonBool;
+    case 'n':
+        return JsonValueType::JsonNull;
+    default:
+        return JsonValueType::JsonNumber;
+    }
+}
+
+auto JsonLazyValue::find(std::string_view key) const -> ErrorOr<JsonLazyValue> {
+    const auto result = TRY(try_find(key));
+
+    if (not result)
+        return JsonError(JsonErrorCode::KeyNotFound, m_offset, key);
+
+    return *result;
+}
+
+auto JsonLazyValue::at(std::size_t index) const -> ErrorOr<JsonLazyValue> {
+    const auto result = TRY(try_at(index));
+
+    if (not result)
+        return JsonError::index_out_of_range(index, m_offset);
+
+    return *result;
+}
+
+auto JsonLazyValue::try_find(std::string_view key) const -> ErrorOr<std::optional<JsonLazyValue>> {
+    TRY(expect_container('{'));
+
+    std::optional<JsonLazyValue> result;
+
+    TRY(walk_container(m_input, m_offset, [&](std::string_view member_key, JsonLazyValue value) {
+                if (member_key != key)
+                    return true;
+
+                result = value;
+
+                return false;
+                }));
+
+    return result;
+}
+
+auto JsonLazyValue::try_at(std::size_t index) const -> ErrorOr<std::optional<JsonLazyValue>> {
+    TRY(expect_container('['));
+
+    std::optional<JsonLazyValue> result;
+    std::size_t current = 0;
+
+    TRY(walk_container(m_input, m_offset, [&](std::string_view, JsonLazyValue value) {
+                if (current++ != index)
+                    return true;
+
+                result = value;
+
+                return false;
+                }));
+
+    return result;
+}
+
+auto JsonLazyValue::elements() const -> ErrorOr<std::vector<JsonLazyValue>> {
+    TRY(expect_container('['));
+
+    std::vector<JsonLazyValue> result;
+
+    TRY(walk_container(m_input, m_offset, [&](std::string_view, JsonLazyValue value) {
+                result.push_back(value);
+                return true;
+                }));
+
+    return result;
+}
+
+auto JsonLazyValue::members() const -> ErrorOr<std::vector<std::pair<std::string, JsonLazyValue>>> {
+    TRY(expect_container('{'));
+
+    std::vector<std::pair<std::string, JsonLazyValue>> result;
+
+    TRY(walk_container(m_input, m_offset, [&](std::string_view key, JsonLazyValue value) {
+                result.emplace_back(key, value);
+                return true;
+                }));
+
+    return result;
+}
+
+auto JsonLazyValue::size() const -> ErrorOr<std::size_t> {
+    if (get_type() != JsonValueType::JsonObject and get_type() != JsonValueType::JsonArray)
+        return error_type("object or array");
+
+    std::size_t result = 0;
+
+    TRY(walk_container(m_input, m_offset, [&](std::string_view, JsonLazyValue) {
+                result++;
+                return true;
+                }));
+
+    return result;
+}
+
+auto JsonLazyValue::is_null() const -> bool {
+    return m_input.substr(m_offset, 4) == "null";
+}
+
+auto JsonLazyValue::as_bool() const -> ErrorOr<bool> {
+    if (get_type() != JsonValueType::JsonBool)
+        return error_type("boolean");
+
+    auto position = m_offset;
+
+    TRY(skip_value(m_input, position));
+
+    return m_input[m_offset] == 't';
+}
+
+auto JsonLazyValue::as_number() const -> ErrorOr<JsonNumber> {
+    if (get_type() != JsonValueType::JsonNumber)
+        return error_type("number");
+
+    const auto literal = m_input.substr(m_offset, scan_number(m_input.substr(m_offset)));
+
+    if (literal.empty())
+        return error_at(m_input, m_offset);
+
+    const auto number = parse_number_value(literal);
+
+    if (not number)
+        return JsonError(JsonErrorCode::NumberOutOfRange, m_offset, literal);
+
+    return JsonNumber(*number);
+}
+
+auto JsonLazyValue::as_string() const -> ErrorOr<std::string_view> {
+    if (get_type() != JsonValueType::JsonString)
+        return error_type("string");
+
+    auto position = m_offset;
+
+    return scan_string(m_input, position);
+}
+
+auto JsonLazyValue::raw() const -> ErrorOr<std::string_view> {
+    auto position = m_offset;
+
+    TRY(skip_value(m_input, position));
+
+    return m_input.substr(m_offset, position - m_offset);
+}
+
+auto JsonLazyValue::to_value() const -> ErrorOr<std::shared_ptr<JsonValue>> {
+    const auto text = TRY(raw());
+
+    JsonDomBuilder builder;
+
+    TRY(JsonSaxParser<JsonDomBuilder>::parse(text, builder));
+
+    return builder.result();
+}
+
+auto JsonLazyValue::expect_container(char open) const -> ErrorOr<std::monostate> {
+    if (m_input[m_offset] != open)
+        return error_type(open == '{' ? "object" : "array");
+
+    return std::monostate{};
+}
+
+auto JsonLazyValue::error_type(std::string_view expected) const -> JsonError {
+    return JsonError::type_mismatch(expected, get_type(), m_offset);
+}
+
+auto JsonLazyDocument::parse(std::string_view input) -> ErrorOr<JsonLazyDocument> {
+    const auto position = skip_whitespaces(input, 0);
+
+    TRY(check_value_start(input, position));
+
+    return JsonLazyDocument(JsonLazyValue(input, position));
+}
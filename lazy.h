@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "jsonval.h"
+#include "parser.h"
+
+// A value inside a document that has not been parsed yet, just a position
+// in the input. Navigating into it scans only as far as the requested key
+// or index. Siblings in the way are skipped by bracket matching without
+// building anything, and whatever comes after is never looked at.
+//
+// Nothing is validated beyond what is scanned, so a malformed document can
+// still answer questions about its well formed parts. The input has to
+// outlive every value taken from it.
+class JsonLazyValue {
+public:
+    JsonLazyValue(std::string_view input, std::size_t offset)
+        : m_input(input), m_offset(offset) {}
+
+    auto get_type() const -> JsonValueType;
+
+    // member of an object. keys are compared decoded, so "a" finds a
+    // member written as "\u0061".
+    auto find(std::string_view key) const -> ErrorOr<JsonLazyValue>;
+
+    // element of an array.
+    auto at(std::size_t index) const -> ErrorOr<JsonLazyValue>;
+
+    // like find and at, but a missing key or index is not an error. only
+    // malformed input or a value of the wrong type is.
+    auto try_find(std::string_view key) const -> ErrorOr<std::optional<JsonLazyValue>>;
+
+    auto try_at(std::size_t index) const -> ErrorOr<std::optional<JsonLazyValue>>;
+
+    // handles to every child, the children themselves are still unparsed.
+    auto elements() const -> ErrorOr<std::vector<JsonLazyValue>>;
+
+    // the keys are decoded, so they are copies.
+    auto members() const -> ErrorOr<std::vector<std::pair<std::string, JsonLazyValue>>>;
+
+    // number of children, scans the whole container.
+    auto size() const -> ErrorOr<std::size_t>;
+
+    auto is_null() const -> bool;
+
+    auto as_bool() const -> ErrorOr<bool>;
+
+    auto as_number() const -> ErrorOr<JsonNumber>;
+
+    // the raw contents between the quotes.
+    auto as_string() const -> ErrorOr<std::string_view>;
+
+    // the text of the whole value.
+    auto raw() const -> ErrorOr<std::string_view>;
+
+    // fully parses this value and everything below it. error offsets count
+    // from the start of this value.
+    auto to_value() const -> ErrorOr<std::shared_ptr<JsonValue>>;
+
+    auto offset() const -> std::size_t { return m_offset; }
+
+private:
+    auto expect_container(char open) const -> ErrorOr<std::monostate>;
+
+    // expected has to be a string literal.
+    auto error_type(std::string_view expected) const -> JsonError;
+
+private:
+    std::string_view m_input;
+    std::size_t m_offset;
+};
+
+class JsonLazyDocument {
+public:
+    // only checks that the input starts with a value, the rest is scanned
+    // on demand. input has to outlive the document.
+    static auto parse(std::string_view input) -> ErrorOr<JsonLazyDocument>;
+
+    auto root() const -> JsonLazyValue { return m_root; }
+
+    auto find(std::string_view key) const -> ErrorOr<JsonLazyValue> { return m_root.find(key); }
+
+    auto at(std::size_t index) const -> ErrorOr<JsonLazyValue> { return m_root.at(index); }
+
+private:
+    JsonLazyDocument(JsonLazyValue root)
+        : m_root(root) {}
+
+private:
+    JsonLazyValue m_root;
+};
@@ -1,6 +1,18 @@
 #include <cctype>
 
+#include "escape.h"
 #include "lexer.h"
+#include "number.h"
+#include "stats.h"
+
+namespace {
+
+// only these four, std::isspace also takes '\v' and '\f'.
+auto is_whitespace(char c) -> bool {
+    return c == ' ' or c == '\t' or c == '\n' or c == '\r';
+}
+
+}
 
 auto token_to_string(TokenType type) -> std::string_view {
     switch (type) {
@@ -51,17 +63,50 @@ auto Token::type() const -> TokenType {
     return m_type;
 }
 
-auto Token::lexeme() const -> const std::string& {
+auto Token::lexeme() const -> std::string_view {
     return m_lexeme;
 }
 
+auto Token::is_escaped() const -> bool {
+    return m_escaped;
+}
+
+auto Token::text(std::string& scratch) const -> std::string_view {
+    if (not m_escaped)
+        return m_lexeme;
+
+    scratch.clear();
+    unescape_string(m_lexeme, scratch);
+
+    return scratch;
+}
+
 
 auto JsonLexer::is_eof() const -> bool {
     return m_cursor >= m_input.length();
 }
 
 auto JsonLexer::get_token() -> Token {
-    skip_whitespaces();
+    const auto token = scan_token();
+
+    JSON_STATS(count_token(token.type()));
+
+    return token;
+}
+
+auto JsonLexer::token_offset() const -> std::size_t {
+    return m_token_start;
+}
+
+auto JsonLexer::scan_token() -> Token {
+    if (not m_index) {
+        skip_whitespaces();
+    } else if (not seek_next_structural()) {
+        m_token_start = m_cursor;
+        return get_garbage(m_cursor);
+    }
+
+    m_token_start = m_cursor;
 
     if (is_eof())
         return Token(TokenType::EndOfFile);
@@ -97,125 +142,124 @@ auto JsonLexer::get_token() -> Token {
         break;
     }
 
-    if (std::isdigit(current()))
+    if (std::isdigit(current()) or current() == '-')
         return get_number_literal();
 
-    std::string lexeme;
-
-    do {
-        lexeme.push_back(current());
-        advance();
-    } while (not is_eof() and not std::isspace(current()));
-
-    return Token(TokenType::Garbage, std::move(lexeme));
+    return get_garbage(m_cursor);
 }
 
 auto JsonLexer::get_boolean() -> Token {
-    std::string lexeme;
+    const auto start = m_cursor;
 
     do {
-        lexeme.push_back(current());
         advance();
     } while (not is_eof() and std::isalpha(current()));
 
+    const auto lexeme = lexeme_from(start);
+
+    // "true1" is not a literal followed by a number.
+    if (not at_delimiter())
+        return get_garbage(start);
+
     if (lexeme == "true")
         return Token(TokenType::BooleanTrue);
 
     if (lexeme == "false")
         return Token(TokenType::BooleanFalse);
 
-    return Token(TokenType::Garbage, std::move(lexeme));
+    return Token(TokenType::Garbage, lexeme);
 }
 
 auto JsonLexer::get_number_literal() -> Token {
-    if (not std::isdigit(current())) {
-        std::string lexeme;
-
-        do {
-            lexeme.push_back(current());
-            advance();
-        } while (not is_eof() and not std::isspace(current()));
-
-        return Token(TokenType::Garbage, std::move(lexeme));
-    }
+    const auto start = m_cursor;
+    const auto length = scan_number(m_input.substr(start));
 
-    std::string number;
+    if (length == 0)
+        return get_garbage(start);
 
-    do {
-        number.push_back(current());
-        advance();
-    } while (not is_eof() and std::isdigit(current()));
-
-    if (current() == '.') {
-        number.push_back(current());
-        advance();
-
-        if (is_eof() or not std::isdigit(current())) {
-            do {
-                number.push_back(current());
-                advance();
-            } while (not is_eof() and not std::isspace(current()));
-
-            return Token(TokenType::Garbage, std::move(number));
-        }
-
-        do {
-            number.push_back(current());
-            advance();
-        } while (not is_eof() and std::isdigit(current()));
-    }
+    m_cursor += length;
 
-    if (number[0] == '0')
-        return Token(TokenType::Garbage, std::move(number));
+    // "01", "1.5.2" or "12abc" are a valid number followed by junk, not two tokens.
+    if (not at_delimiter())
+        return get_garbage(start);
 
-    return Token(TokenType::NumberLiteral, std::move(number));
+    return Token(TokenType::NumberLiteral, lexeme_from(start));
 }
 
 auto JsonLexer::get_string_literal() -> Token {
-    if (current() != '"') {
-        std::string lexeme;
-
-        do {
-            lexeme.push_back(current());
-            advance();
-        } while (not is_eof() and not std::isspace(current()));
-
-        return Token(TokenType::Garbage, std::move(lexeme));
-    }
+    if (current() != '"')
+        return get_garbage(m_cursor);
 
     // skip the '"'
     advance();
 
-    std::string content;
+    const auto start = m_cursor;
+    const auto scan = scan_string_literal(m_input.substr(start));
 
-    do {
-        content.push_back(current());
-        advance();
-    } while (not is_eof() and current() != '"');
+    if (scan.length == std::string_view::npos) {
+        m_cursor = m_input.length();
+        return Token(TokenType::Garbage, lexeme_from(start));
+    }
 
-    if (is_eof())
-        return Token(TokenType::Garbage, std::move(content));
+    m_cursor += scan.length;
+
+    const auto content = lexeme_from(start);
 
     // skip the '"'
     advance();
 
-    return Token(TokenType::StringLiteral, std::move(content));
+    // escape sequences are kept verbatim until someone asks for the text,
+    // but they have to be well formed, as does the utf-8.
+    if (scan.has_control
+            or scan.has_invalid_escape
+            or (scan.has_non_ascii and not validate_utf8(content)))
+        return Token(TokenType::Garbage, content);
+
+    return Token(TokenType::StringLiteral, content, scan.has_escapes);
 }
 
 auto JsonLexer::get_null() -> Token {
-    std::string lexeme;
+    const auto start = m_cursor;
 
     do {
-        lexeme.push_back(current());
         advance();
     } while (not is_eof() and std::isalpha(current()));
 
+    const auto lexeme = lexeme_from(start);
+
+    if (not at_delimiter())
+        return get_garbage(start);
+
     if (lexeme != "null")
-        return Token(TokenType::Garbage, std::move(lexeme));
+        return Token(TokenType::Garbage, lexeme);
 
     return Token(TokenType::Null);
 }
 
+auto JsonLexer::get_garbage(std::size_t start) -> Token {
+    while (not is_eof() and not is_whitespace(current()))
+        advance();
+
+    return Token(TokenType::Garbage, lexeme_from(start));
+}
+
+auto JsonLexer::at_delimiter() const -> bool {
+    switch (current()) {
+    case 0:
+    case ',':
+    case ':':
+    case ']':
+    case '}':
+        return true;
+    default:
+        return is_whitespace(current());
+    }
+}
+
+auto JsonLexer::lexeme_from(std::size_t start) const -> std::string_view {
+    return m_input.substr(start, m_cursor - start);
+}
+
 auto JsonLexer::current() const -> char {
     if (is_eof())
         return 0;
@@ -231,6 +275,32 @@ auto JsonLexer::advance() -> void {
 }
 
 auto JsonLexer::skip_whitespaces() -> void {
-    while (not is_eof() and std::isspace(current()))
+    while (not is_eof() and is_whitespace(current()))
         advance();
 }
+
+auto JsonLexer::seek_next_structural() -> bool {
+    const auto& positions = m_index->positions();
+
+    // skip offsets that the previous token already consumed, e.g. the
+    // second half of a garbage lexeme.
+    while (m_next_structural < positions.size() and positions[m_next_structural] < m_cursor)
+        m_next_structural++;
+
+    const auto next = m_next_structural == positions.size() ? m_input.length() : positions[m_next_structural];
+
+    // the byte right after a token is either the next offset or whitespace,
+    // junk that follows whitespace starts a scalar and is indexed itself.
+    // anything else was left unconsumed and must not be jumped over.
+    if (m_cursor < next and not is_whitespace(current()))
+        return false;
+
+    if (m_next_structural == positions.size()) {
+        m_cursor = m_input.length();
+        return true;
+    }
+
+    m_cursor = positions[m_next_structural++];
+
+    return true;
+}
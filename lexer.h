@@ -1,9 +1,12 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <string_view>
 
-enum class TokenType {
+#include "indexer.h"
+
+enum class TokenType : std::uint8_t {
     OpenCurlyBrace, /* { */
     CloseCurlyBrace,  /* } */
     OpenBrace, /* [ */
@@ -33,34 +36,30 @@ public:
     Token(TokenType type)
         : m_type(type) {}
 
-    Token(TokenType type, std::string lexeme)
-        : m_type(type), m_lexeme(std::move(lexeme)) {}
-
-    Token(Token&& other)
-        : m_type(other.m_type), m_lexeme(std::move(other.m_lexeme)) 
-    {
-        other.m_type = TokenType::Garbage;
-    }
-
-    auto operator=(const Token& other) -> Token& = delete;
-
-    auto operator=(Token&& other) -> Token& {
-        m_type = other.m_type;
-        m_lexeme = std::move(other.m_lexeme);
-
-        other.m_type = TokenType::Garbage;
-        return *this;
-    }
+    // the lexeme is a view into the lexer's input, so a token is only valid
+    // for as long as the buffer it was scanned from.
+    Token(TokenType type, std::string_view lexeme, bool escaped = false)
+        : m_type(type), m_escaped(escaped), m_lexeme(lexeme) {}
 
     auto to_string() const -> std::string;
 
     auto type() const -> TokenType;
 
-    auto lexeme() const -> const std::string&;
+    // string literals without their quotes and with escape sequences as
+    // written.
+    auto lexeme() const -> std::string_view;
+
+    // whether a string literal has escape sequences to decode.
+    auto is_escaped() const -> bool;
+
+    // the decoded contents of a string literal. a view of the lexeme unless
+    // it has escapes, which are decoded into scratch.
+    auto text(std::string& scratch) const -> std::string_view;
 
 private:
     TokenType m_type{TokenType::Garbage};
-    std::string m_lexeme;
+    bool m_escaped{false};
+    std::string_view m_lexeme;
 };
 
 class JsonLexer {
@@ -68,11 +67,22 @@ public:
     JsonLexer(std::string_view input)
         : m_input(input) {}
 
+    // jump from one structural offset to the next instead of skipping
+    // whitespace, the index has to outlive the lexer.
+    JsonLexer(std::string_view input, const StructuralIndex& index)
+        : m_input(input), m_index(&index) {}
+
     auto is_eof() const -> bool;
 
     auto get_token() -> Token;
 
+    // where the last token returned by get_token starts, the input length
+    // for end of file. tokens do not carry it to stay small.
+    auto token_offset() const -> std::size_t;
+
 private:
+    auto scan_token() -> Token;
+
     auto get_boolean() -> Token;
 
     auto get_number_literal() -> Token;
@@ -81,13 +91,28 @@ private:
 
     auto get_null() -> Token;
 
+    auto get_garbage(std::size_t start) -> Token;
+
+    // whether the cursor may end a scalar: whitespace, ',', ':', ']', '}'
+    // or end of input.
+    auto at_delimiter() const -> bool;
+
+    auto lexeme_from(std::size_t start) const -> std::string_view;
+
     auto current() const -> char;
 
     auto advance() -> void;
 
     auto skip_whitespaces() -> void;
 
+    // false if the previous token left junk behind, the cursor is on it.
+    auto seek_next_structural() -> bool;
+
 private:
     std::size_t m_cursor{0};
+    std::size_t m_token_start{0};
     std::string_view m_input;
+
+    const StructuralIndex* m_index{nullptr};
+    std::size_t m_next_structural{0};
 };
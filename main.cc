@@ -1,17 +1,9 @@
 #include <iostream>
-#include <fstream>
-#include <sstream>
 
 #include "parser.h"
 
 auto main() -> int {
-    std::ifstream file("dummy.json");
-    std::stringstream ss;
-    ss << file.rdbuf();
-
-    const auto str = ss.str();
-
-    auto json = std::get<1>(JsonParser::parse(str));
+    auto json = std::get<1>(JsonParser::parse_file("dummy.json"));
 
     // TODO: implement a more friendly and safe way to access values inside json object.
     // currently you gotta do the "not friendly and unsafe" way lmao :^)
@@ -30,8 +22,7 @@ auto main() -> int {
                     });
             });
 
-    // TODO: prettify json serializer
-    std::cout << json.serialize() << '\n';
+    std::cout << json.serialize(JsonWriterOptions{.pretty = true}) << '\n';
 
     return 0;
 }
@@ -0,0 +1,118 @@
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped_file.h"
+
+namespace {
+
+// captures errno right away, close() may overwrite it.
+auto make_error(const std::string& path, std::string_view what) -> JsonError {
+    return JsonError::file_error(path, what, errno);
+}
+
+}
+
+MappedFile::MappedFile(MappedFile&& other)
+    : m_mapping(other.m_mapping), m_length(other.m_length), m_buffer(std::move(other.m_buffer))
+{
+    other.m_mapping = nullptr;
+    other.m_length = 0;
+}
+
+auto MappedFile::operator=(MappedFile&& other) -> MappedFile& {
+    if (this == &other)
+        return *this;
+
+    release();
+
+    m_mapping = other.m_mapping;
+    m_length = other.m_length;
+    m_buffer = std::move(other.m_buffer);
+
+    other.m_mapping = nullptr;
+    other.m_length = 0;
+
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+auto MappedFile::open(const std::string& path) -> ErrorOr<MappedFile> {
+    const auto fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+        return make_error(path, "cannot open");
+
+    MappedFile file;
+
+    struct stat info;
+
+    // procfs and sysfs report regular files of size zero that still have
+    // contents, and mmap refuses empty mappings anyway, so those are read.
+    if (::fstat(fd, &info) == 0 and S_ISREG(info.st_mode) and info.st_size > 0) {
+        file.m_length = static_cast<std::size_t>(info.st_size);
+
+        const auto mapping = ::mmap(nullptr, file.m_length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (mapping != MAP_FAILED) {
+            ::madvise(mapping, file.m_length, MADV_SEQUENTIAL);
+            ::close(fd);
+
+            file.m_mapping = mapping;
+            return file;
+        }
+
+        file.m_length = 0;
+    }
+
+    // not mappable, read it in the old fashioned way.
+    char chunk[64 * 1024];
+
+    while (true) {
+        const auto count = ::read(fd, chunk, sizeof(chunk));
+
+        if (count == 0)
+            break;
+
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+
+            auto error = make_error(path, "cannot read");
+            ::close(fd);
+
+            return error;
+        }
+
+        file.m_buffer.append(chunk, static_cast<std::size_t>(count));
+    }
+
+    ::close(fd);
+
+    return file;
+}
+
+auto MappedFile::contents() const -> std::string_view {
+    if (m_mapping)
+        return std::string_view(static_cast<const char*>(m_mapping), m_length);
+
+    return m_buffer;
+}
+
+auto MappedFile::is_mapped() const -> bool {
+    return m_mapping != nullptr;
+}
+
+auto MappedFile::release() -> void {
+    if (m_mapping)
+        ::munmap(m_mapping, m_length);
+
+    m_mapping = nullptr;
+    m_length = 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "parser.h"
+
+// Read-only view of a whole file. Regular files are mmapped, anything else
+// (pipes, character devices, files that claim to be empty like those in
+// /proc, ...) falls back to reading into a buffer.
+class MappedFile {
+public:
+    MappedFile() = default;
+
+    MappedFile(const MappedFile& other) = delete;
+
+    MappedFile(MappedFile&& other);
+
+    auto operator=(MappedFile&& other) -> MappedFile&;
+
+    ~MappedFile();
+
+    static auto open(const std::string& path) -> ErrorOr<MappedFile>;
+
+    auto contents() const -> std::string_view;
+
+    auto is_mapped() const -> bool;
+
+private:
+    auto release() -> void;
+
+private:
+    void* m_mapping{nullptr};
+    std::size_t m_length{0};
+
+    std::string m_buffer;
+};
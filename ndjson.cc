@@ -0,0 +1,257 @@
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "ndjson.h"
+
+namespace {
+
+struct Batch {
+    Batch(std::size_t begin, std::size_t end)
+        : begin(begin), end(end) {}
+
+    std::size_t begin;
+    std::size_t end;
+
+    // only counted up front for unordered delivery.
+    std::size_t first_index{0};
+
+    std::vector<NdjsonRecord> records;
+    std::size_t error_count{0};
+};
+
+// one per worker, the owner pops from the front and thieves take from the
+// back so they rarely fight over the same end.
+class WorkQueue {
+public:
+    auto push(std::size_t batch) -> void {
+        std::lock_guard lock(m_mutex);
+
+        m_batches.push_back(batch);
+    }
+
+    auto pop() -> std::optional<std::size_t> {
+        std::lock_guard lock(m_mutex);
+
+        if (m_batches.empty())
+            return std::nullopt;
+
+        const auto batch = m_batches.front();
+        m_batches.pop_front();
+
+        return batch;
+    }
+
+    auto steal() -> std::optional<std::size_t> {
+        std::lock_guard lock(m_mutex);
+
+        if (m_batches.empty())
+            return std::nullopt;
+
+        const auto batch = m_batches.back();
+        m_batches.pop_back();
+
+        return batch;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::deque<std::size_t> m_batches;
+};
+
+auto is_blank(std::string_view line) -> bool {
+    for (const auto c : line) {
+        if (c != ' ' and c != '\t' and c != '\r')
+            return false;
+    }
+
+    return true;
+}
+
+// calls f(line, offset) for every line of the batch that is not blank.
+template<typename F>
+auto for_each_record(std::string_view input, const Batch& batch, F f) -> void {
+    auto line_begin = batch.begin;
+
+    while (line_begin < batch.end) {
+        const auto newline = static_cast<const char*>(std::memchr(input.data() + line_begin, '\n', batch.end - line_begin));
+        const auto line_end = newline ? static_cast<std::size_t>(newline - input.data()) : batch.end;
+
+        const auto line = input.substr(line_begin, line_end - line_begin);
+
+        if (not is_blank(line))
+            f(line, line_begin);
+
+        line_begin = line_end + 1;
+    }
+}
+
+auto split_batches(std::string_view input, std::size_t batch_bytes) -> std::vector<Batch> {
+    std::vector<Batch> batches;
+
+    std::size_t begin = 0;
+
+    while (begin < input.length()) {
+        auto end = std::min(begin + std::max<std::size_t>(batch_bytes, 1), input.length());
+
+        if (end < input.length()) {
+            const auto newline = static_cast<const char*>(std::memchr(input.data() + end, '\n', input.length() - end));
+
+            end = newline ? static_cast<std::size_t>(newline - input.data()) + 1 : input.length();
+        }
+
+        batches.emplace_back(begin, end);
+        begin = end;
+    }
+
+    return batches;
+}
+
+auto parse_batch(std::string_view input, Batch& batch, const JsonParserOptions& options) -> void {
+    for_each_record(input, batch, [&](std::string_view line, std::size_t offset) {
+            auto result = JsonParser::parse(line, options);
+
+            if (std::holds_alternative<JsonError>(result))
+                batch.error_count++;
+
+            // the index is filled in on delivery.
+            batch.records.push_back(NdjsonRecord{0, offset, std::move(result)});
+            });
+}
+
+// hands finished batches to the callback one at a time and frees them. in
+// order, a batch waits for every batch before it, otherwise it goes out as
+// soon as it is done.
+class Delivery {
+public:
+    Delivery(std::vector<Batch>& batches, bool ordered, const NdjsonCallback& callback)
+        : m_batches(batches), m_ordered(ordered), m_callback(callback), m_done(batches.size(), false) {}
+
+    auto finish(std::size_t batch) -> void {
+        std::lock_guard lock(m_mutex);
+
+        if (not m_ordered) {
+            deliver(m_batches[batch]);
+            return;
+        }
+
+        m_done[batch] = true;
+
+        while (m_next < m_batches.size() and m_done[m_next])
+            deliver(m_batches[m_next++]);
+    }
+
+    auto result() const -> NdjsonResult {
+        return NdjsonResult{{}, m_record_count, m_error_count};
+    }
+
+private:
+    auto deliver(Batch& batch) -> void {
+        // batches in order are delivered one after the other, so the running
+        // count is where this one starts.
+        const auto first_index = m_ordered ? m_record_count : batch.first_index;
+
+        for (std::size_t i = 0; i < batch.records.size(); i++) {
+            batch.records[i].index = first_index + i;
+            m_callback(std::move(batch.records[i]));
+        }
+
+        m_record_count += batch.records.size();
+        m_error_count += batch.error_count;
+
+        batch.records.clear();
+        batch.records.shrink_to_fit();
+    }
+
+private:
+    std::vector<Batch>& m_batches;
+    bool m_ordered;
+    const NdjsonCallback& m_callback;
+
+    std::mutex m_mutex;
+    std::vector<bool> m_done;
+    std::size_t m_next{0};
+
+    std::size_t m_record_count{0};
+    std::size_t m_error_count{0};
+};
+
+}
+
+auto parse_many(std::string_view input, const NdjsonOptions& options, const NdjsonCallback& callback) -> NdjsonResult {
+    auto batches = split_batches(input, options.batch_bytes);
+
+    if (not options.ordered) {
+        std::size_t record_count = 0;
+
+        for (auto& batch : batches) {
+            batch.first_index = record_count;
+
+            for_each_record(input, batch, [&record_count](std::string_view, std::size_t) {
+                    record_count++;
+                    });
+        }
+    }
+
+    Delivery delivery(batches, options.ordered, callback);
+
+    auto threads = options.threads != 0 ? options.threads : std::thread::hardware_concurrency();
+    threads = std::max<std::size_t>(1, std::min<std::size_t>(threads, batches.size()));
+
+    if (threads == 1) {
+        for (std::size_t i = 0; i < batches.size(); i++) {
+            parse_batch(input, batches[i], options.parser);
+            delivery.finish(i);
+        }
+
+        return delivery.result();
+    }
+
+    std::vector<WorkQueue> queues(threads);
+
+    for (std::size_t i = 0; i < batches.size(); i++)
+        queues[i % threads].push(i);
+
+    const auto work = [&](std::size_t self) {
+        while (true) {
+            auto batch = queues[self].pop();
+
+            for (std::size_t i = 1; not batch and i < threads; i++)
+                batch = queues[(self + i) % threads].steal();
+
+            // every batch is queued up front, so empty queues mean we are done.
+            if (not batch)
+                return;
+
+            parse_batch(input, batches[*batch], options.parser);
+            delivery.finish(*batch);
+        }
+    };
+
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(threads - 1);
+
+        for (std::size_t i = 1; i < threads; i++)
+            workers.emplace_back(work, i);
+
+        work(0);
+    }
+
+    return delivery.result();
+}
+
+auto parse_many(std::string_view input, const NdjsonOptions& options) -> NdjsonResult {
+    std::vector<NdjsonRecord> records;
+
+    auto result = parse_many(input, options, [&records](NdjsonRecord&& record) {
+            records.push_back(std::move(record));
+            });
+
+    result.records = std::move(records);
+
+    return result;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "jsonval.h"
+#include "parser.h"
+
+struct NdjsonOptions {
+    // worker threads, zero picks std::thread::hardware_concurrency.
+    std::size_t threads{0};
+
+    // the input is cut into batches of roughly this many bytes, always at a
+    // line boundary. a batch is the unit of work that gets stolen.
+    std::size_t batch_bytes{1 << 20};
+
+    // deliver records in input order. otherwise batches are delivered in the
+    // order they finished, so with a callback a slow batch never holds back
+    // the ones after it. record indices are exact either way, unordered
+    // parsing counts the records of every batch up front to get them.
+    bool ordered{true};
+
+    // handed to every record's parser, a shared key table lets records with
+    // the same shape share their keys across all workers.
+    JsonParserOptions parser{};
+};
+
+struct NdjsonRecord {
+    // position among the records of the input, blank lines do not count.
+    std::size_t index;
+
+    // byte offset of the line in the input.
+    std::size_t offset;
+
+    ErrorOr<JsonObject> result;
+};
+
+struct NdjsonResult {
+    std::vector<NdjsonRecord> records;
+
+    std::size_t record_count{0};
+    std::size_t error_count{0};
+};
+
+using NdjsonCallback = std::function<void(NdjsonRecord&& record)>;
+
+// Parses newline delimited json, one object per line, on a pool of worker
+// threads. A malformed record only fails its own entry, the rest of the
+// batch is still parsed.
+auto parse_many(std::string_view input, const NdjsonOptions& options = {}) -> NdjsonResult;
+
+// Streams the records to callback as soon as their batch can be delivered
+// and lets go of the batch right after, instead of collecting everything.
+// The callback runs on the worker threads but never on two at once. The
+// records of the result stay empty.
+auto parse_many(std::string_view input, const NdjsonOptions& options, const NdjsonCallback& callback) -> NdjsonResult;
@@ -0,0 +1,267 @@
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "number.h"
+
+namespace {
+
+auto is_digit(char c) -> bool {
+    return c >= '0' and c <= '9';
+}
+
+// every power of ten up to 22 is exactly representable as a double.
+constexpr double exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+constexpr std::uint64_t max_exact_mantissa = std::uint64_t{1} << 53;
+
+// SWAR conversion of eight ascii digits, false if any of them is not a digit.
+auto parse_eight_digits(const char* digits, std::uint64_t& value) -> bool {
+    std::uint64_t chunk;
+    std::memcpy(&chunk, digits, sizeof(chunk));
+
+    // every byte in '0'..'9' has 0x3 in its high nibble and stays below 0x3a.
+    if ((((chunk & 0xF0F0F0F0F0F0F0F0) | (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4))) != 0x3333333333333333)
+        return false;
+
+    chunk = ((chunk & 0x0F0F0F0F0F0F0F0F) * 2561) >> 8;
+    chunk = ((chunk & 0x00FF00FF00FF00FF) * 6553601) >> 16;
+
+    value = value * 100000000 + (((chunk & 0x0000FFFF0000FFFF) * 42949672960001) >> 32);
+
+    return true;
+}
+
+// magnitude of a literal made only of digits (after the sign), or nullopt
+// if it has a fraction, an exponent or more than 64 bits.
+auto parse_integral(std::string_view digits) -> std::optional<std::uint64_t> {
+    // 20 digits is the most a uint64 can hold, and even that can overflow.
+    if (digits.empty() or digits.length() > 20)
+        return std::nullopt;
+
+    const auto* cursor = digits.data();
+    const auto* const end = digits.data() + digits.length();
+
+    std::uint64_t value = 0;
+
+    // at most 19 digits are folded without an overflow check.
+    const auto* const safe_end = digits.length() == 20 ? end - 1 : end;
+
+    if constexpr (std::endian::native == std::endian::little) {
+        while (safe_end - cursor >= 8 and parse_eight_digits(cursor, value))
+            cursor += 8;
+    }
+
+    for (; cursor != safe_end; cursor++) {
+        const auto digit = static_cast<unsigned char>(*cursor - '0');
+
+        if (digit > 9)
+            return std::nullopt;
+
+        value = value * 10 + digit;
+    }
+
+    if (cursor != end) {
+        const auto digit = static_cast<unsigned char>(*cursor - '0');
+
+        if (digit > 9 or __builtin_mul_overflow(value, 10, &value) or __builtin_add_overflow(value, digit, &value))
+            return std::nullopt;
+    }
+
+    return value;
+}
+
+}
+
+auto scan_number(std::string_view input) -> std::size_t {
+    std::size_t i = 0;
+
+    if (i < input.length() and input[i] == '-')
+        i++;
+
+    if (i == input.length() or not is_digit(input[i]))
+        return 0;
+
+    // a leading zero can not be followed by more integer digits.
+    if (input[i] == '0') {
+        i++;
+    } else {
+        while (i < input.length() and is_digit(input[i]))
+            i++;
+    }
+
+    if (i < input.length() and input[i] == '.') {
+        if (i + 1 == input.length() or not is_digit(input[i + 1]))
+            return 0;
+
+        i++;
+
+        while (i < input.length() and is_digit(input[i]))
+            i++;
+    }
+
+    if (i < input.length() and (input[i] == 'e' or input[i] == 'E')) {
+        auto j = i + 1;
+
+        if (j < input.length() and (input[j] == '+' or input[j] == '-'))
+            j++;
+
+        if (j == input.length() or not is_digit(input[j]))
+            return 0;
+
+        while (j < input.length() and is_digit(input[j]))
+            j++;
+
+        i = j;
+    }
+
+    return i;
+}
+
+auto parse_number(std::string_view literal) -> std::optional<double> {
+    if (literal.empty() or scan_number(literal) != literal.length())
+        return std::nullopt;
+
+    const auto* cursor = literal.data();
+    const auto* const end = literal.data() + literal.length();
+
+    const auto negative = *cursor == '-';
+
+    if (negative)
+        cursor++;
+
+    std::uint64_t mantissa = 0;
+    int significant_digits = 0;
+    int exponent = 0;
+    bool truncated = false;
+
+    // leading zeros are not significant, digits past the 19th would overflow
+    // the mantissa and only shift the exponent.
+    for (; cursor != end and is_digit(*cursor); cursor++) {
+        if (significant_digits < 19) {
+            mantissa = mantissa * 10 + static_cast<std::uint64_t>(*cursor - '0');
+            significant_digits += mantissa != 0;
+        } else {
+            truncated |= *cursor != '0';
+            exponent++;
+        }
+    }
+
+    if (cursor != end and *cursor == '.') {
+        for (cursor++; cursor != end and is_digit(*cursor); cursor++) {
+            if (significant_digits < 19) {
+                mantissa = mantissa * 10 + static_cast<std::uint64_t>(*cursor - '0');
+                significant_digits += mantissa != 0;
+                exponent--;
+            } else {
+                truncated |= *cursor != '0';
+            }
+        }
+    }
+
+    if (cursor != end) {
+        cursor++;
+
+        const auto negative_exponent = *cursor == '-';
+
+        if (*cursor == '-' or *cursor == '+')
+            cursor++;
+
+        int explicit_exponent = 0;
+
+        for (; cursor != end; cursor++) {
+            if (explicit_exponent < 100000)
+                explicit_exponent = explicit_exponent * 10 + (*cursor - '0');
+        }
+
+        exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+    }
+
+    // Clinger's fast path: both operands are exact, so is the one rounding.
+    if (not truncated and mantissa <= max_exact_mantissa and exponent >= -22 and exponent <= 22) {
+        auto value = static_cast<double>(mantissa);
+
+        if (exponent < 0)
+            value /= exact_powers_of_ten[-exponent];
+        else
+            value *= exact_powers_of_ten[exponent];
+
+        return negative ? -value : value;
+    }
+
+    double value = 0.0;
+
+    const auto [ptr, error] = std::from_chars(literal.data(), end, value);
+
+    if (error == std::errc::result_out_of_range) {
+        // decimal exponent of the leading significant digit.
+        if (mantissa != 0 and significant_digits + exponent > 0)
+            return std::nullopt;
+
+        return negative ? -0.0 : 0.0;
+    }
+
+    if (error != std::errc() or ptr != end)
+        return std::nullopt;
+
+    return value;
+}
+
+auto parse_number_value(std::string_view literal) -> std::optional<NumberValue> {
+    const auto negative = not literal.empty() and literal[0] == '-';
+
+    // leading zeros are only valid as "0" on their own, scan_number catches the rest.
+    if (const auto magnitude = parse_integral(literal.substr(negative ? 1 : 0))) {
+        if (literal.length() > (negative ? 2u : 1u) and literal[negative] == '0')
+            return std::nullopt;
+
+        if (not negative) {
+            if (*magnitude <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()))
+                return NumberValue(static_cast<std::int64_t>(*magnitude));
+
+            return NumberValue(*magnitude);
+        }
+
+        if (*magnitude == 0)
+            return NumberValue(-0.0);
+
+        if (*magnitude <= static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()) + 1)
+            return NumberValue(static_cast<std::int64_t>(0 - *magnitude));
+    }
+
+    const auto number = parse_number(literal);
+
+    if (not number)
+        return std::nullopt;
+
+    return NumberValue(*number);
+}
+
+auto format_number(double number, char* buffer) -> std::size_t {
+    if (not std::isfinite(number)) {
+        std::memcpy(buffer, "null", 4);
+        return 4;
+    }
+
+    const auto [ptr, error] = std::to_chars(buffer, buffer + max_number_length, number);
+
+    return static_cast<std::size_t>(ptr - buffer);
+}
+
+auto format_number(std::int64_t number, char* buffer) -> std::size_t {
+    const auto [ptr, error] = std::to_chars(buffer, buffer + max_number_length, number);
+
+    return static_cast<std::size_t>(ptr - buffer);
+}
+
+auto format_number(std::uint64_t number, char* buffer) -> std::size_t {
+    const auto [ptr, error] = std::to_chars(buffer, buffer + max_number_length, number);
+
+    return static_cast<std::size_t>(ptr - buffer);
+}
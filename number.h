@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <variant>
+
+// integral literals keep their exact value, everything else is a double.
+using NumberValue = std::variant<std::int64_t, std::uint64_t, double>;
+
+// longest output of format_number, sign and exponent included.
+constexpr std::size_t max_number_length = 32;
+
+// Length of the json number (RFC 8259 grammar) at the start of input, zero
+// if there is none. Only the grammar is checked, not what follows it.
+auto scan_number(std::string_view input) -> std::size_t;
+
+// Exact, locale independent conversion of a complete json number literal.
+// Short literals take a fast path, everything else goes through
+// std::from_chars (Eisel-Lemire in libstdc++). Fails on malformed input and
+// on values too large for a double, values too small round to zero.
+auto parse_number(std::string_view literal) -> std::optional<double>;
+
+// Like parse_number, but a literal without fraction or exponent that fits
+// in 64 bits comes back as an exact int64, or uint64 above INT64_MAX. -0 is
+// kept as a double so its sign survives.
+auto parse_number_value(std::string_view literal) -> std::optional<NumberValue>;
+
+// Shortest text that reads back to the same double. Infinities and NaN have
+// no json representation and come out as null. buffer must have room for
+// max_number_length chars, returns the length written.
+auto format_number(double number, char* buffer) -> std::size_t;
+
+auto format_number(std::int64_t number, char* buffer) -> std::size_t;
+
+auto format_number(std::uint64_t number, char* buffer) -> std::size_t;
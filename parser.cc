@@ -1,10 +1,42 @@
 #include "parser.h"
-#include <cstdlib>
+#include "lazy.h"
+#include "mapped_file.h"
+#include "number.h"
+#include "stats.h"
 
-auto JsonParser::parse(std::string_view input) -> ErrorOr<JsonObject> {
-    JsonParser parser(input);
+auto JsonParser::parse(std::string_view input, const JsonParserOptions& options) -> ErrorOr<JsonObject> {
+    JSON_STATS(bytes_scanned += input.length());
 
-    return parser.parse_json_object();
+    if (input.length() > StructuralIndex::max_input_size) {
+        JSON_PHASE(JsonPhase::Parse);
+
+        JsonParser parser(input, options);
+
+        return parser.parse_document();
+    }
+
+    const auto index = StructuralIndex::build(input);
+
+    // the index build is a phase of its own.
+    JSON_PHASE(JsonPhase::Parse);
+
+    JsonParser parser(input, index, options);
+
+    return parser.parse_document();
+}
+
+auto JsonParser::parse_file(const std::string& path, const JsonParserOptions& options) -> ErrorOr<JsonObject> {
+    const auto file = TRY(MappedFile::open(path));
+
+    return parse(file.contents(), options);
+}
+
+auto JsonParser::parse_lazy(std::string_view input) -> ErrorOr<JsonLazyDocument> {
+    return JsonLazyDocument::parse(input);
+}
+
+auto JsonParser::validate(std::string_view input, const JsonValidateOptions& options) -> ErrorOr<std::monostate> {
+    return JsonValidator::validate(input, options);
 }
 
 auto JsonParser::advance() -> void {
@@ -18,53 +50,53 @@ auto JsonParser::expect(TokenType type) -> bool {
     return m_current.type() == type;
 }
 
-auto JsonParser::eat_token(TokenType type) -> void {
-    if (not expect(type)) {
-        std::string error;
+auto JsonParser::eat_token(TokenType type) -> ErrorOr<std::monostate> {
+    if (not expect(type))
+        return JsonError::expected_token(type, m_current.type(), m_lexer.token_offset());
 
-        error.append("ERROR: expected: ");
-        error.append(token_to_string(type));
-        error.append(" but got: ");
-        error.append(token_to_string(m_current.type()));
+    advance();
 
-        m_error_stack.push_back(std::move(error));
-    }
+    return std::monostate{};
+}
 
-    advance();
+auto JsonParser::error_unexpected_token() const -> JsonError {
+    return JsonError::unexpected_token(m_current.type(), m_lexer.token_offset());
 }
 
-auto JsonParser::parse_json_boolean() -> ErrorOr<JsonBool> {
-    if (not expect(TokenType::BooleanTrue) and not expect(TokenType::BooleanFalse)) {
-        std::string error;
+auto JsonParser::parse_document() -> ErrorOr<JsonObject> {
+    auto object = TRY(parse_json_object());
 
-        error.append("ERROR: expected: boolean but got: ");
-        error.append(token_to_string(m_current.type()));
+    // only whitespace may follow, "{} {}" is not one document.
+    TRY(eat_token(TokenType::EndOfFile));
 
-        m_error_stack.push_back(std::move(error));
+    return object;
+}
 
-        return m_error_stack;
-    }
+auto JsonParser::parse_json_boolean() -> ErrorOr<JsonBool> {
+    if (not expect(TokenType::BooleanTrue) and not expect(TokenType::BooleanFalse))
+        return error_unexpected_token();
 
     auto result = JsonBool(expect(TokenType::BooleanTrue) ? true : false);
 
+    JSON_STATS(count_node(JsonValueType::JsonBool));
+
     advance();
 
     return result;
 }
 
 auto JsonParser::parse_json_number() -> ErrorOr<JsonNumber> {
-    if (not expect(TokenType::NumberLiteral)) {
-        std::string error;
+    if (not expect(TokenType::NumberLiteral))
+        return error_unexpected_token();
 
-        error.append("ERROR: expected: number but got: ");
-        error.append(token_to_string(m_current.type()));
+    const auto number = parse_number_value(m_current.lexeme());
 
-        m_error_stack.push_back(std::move(error));
+    if (not number)
+        return JsonError(JsonErrorCode::NumberOutOfRange, m_lexer.token_offset(), m_current.lexeme());
 
-        return m_error_stack;
-    }
+    auto result = JsonNumber(*number);
 
-    auto result = JsonNumber(std::strtod(m_current.lexeme().c_str(), nullptr));
+    JSON_STATS(count_node(JsonValueType::JsonNumber));
 
     advance();
 
@@ -72,18 +104,21 @@ auto JsonParser::parse_json_number() -> ErrorOr<JsonNumber> {
 }
 
 auto JsonParser::parse_json_string() -> ErrorOr<JsonString> {
-    if (not expect(TokenType::StringLiteral)) {
-        std::string error;
+    if (not expect(TokenType::StringLiteral))
+        return error_unexpected_token();
 
-        error.append("ERROR: expected: string but got: ");
-        error.append(token_to_string(m_current.type()));
+    const auto text = m_current.text(m_scratch);
 
-        m_error_stack.push_back(std::move(error));
+    const auto interned = m_options.key_table and text.length() <= m_options.intern_values_up_to;
 
-        return m_error_stack;
-    }
+    auto result = interned
+        ? JsonString::interned(m_options.key_table->intern(text))
+        : JsonString(std::string(text));
+
+    JSON_STATS(count_node(JsonValueType::JsonString));
 
-    auto result = JsonString(m_current.lexeme());
+    if (not interned)
+        JSON_STATS(count_string(text.length()));
 
     advance();
 
@@ -91,112 +126,100 @@ auto JsonParser::parse_json_string() -> ErrorOr<JsonString> {
 }
 
 auto JsonParser::parse_json_object() -> ErrorOr<JsonObject> {
-    eat_token(TokenType::OpenCurlyBrace);
+    JSON_DEPTH();
+
+    TRY(eat_token(TokenType::OpenCurlyBrace));
 
     auto object = JsonObject{};
 
+    JSON_STATS(count_node(JsonValueType::JsonObject));
+
     if (expect(TokenType::CloseCurlyBrace)) {
         advance();
         return object;
     }
 
     while (true) {
-        if (expect(TokenType::EndOfFile)) {
-            std::string error;
+        if (expect(TokenType::EndOfFile))
+            return error_unexpected_token();
 
-            error.append("ERROR: unexpected end of file");
-
-            m_error_stack.push_back(std::move(error));
-
-            return m_error_stack;
-        }
+        if (not expect(TokenType::StringLiteral))
+            return JsonError::expected_token(TokenType::StringLiteral, m_current.type(), m_lexer.token_offset());
 
+        // the only copy of the key is the one the dictionary owns.
+        auto key = make_key(m_current.text(m_scratch));
 
-        const auto key = m_current.lexeme();
+        advance();
 
-        eat_token(TokenType::StringLiteral);
-        eat_token(TokenType::Colon);
+        TRY(eat_token(TokenType::Colon));
 
         if (expect(TokenType::BooleanTrue)) {
             auto _true = TRY(parse_json_boolean());
             object.access([&key, &_true](JsonObjectDict& dict) {
-                    dict[key] = make_json_value<JsonBool>(std::move(_true));
+                    dict.insert_or_assign(std::move(key), make_json_value<JsonBool>(std::move(_true)));
                     });
         } else if (expect(TokenType::BooleanFalse)) {
             auto _false = TRY(parse_json_boolean());
             object.access([&key, &_false](JsonObjectDict& dict) {
-                    dict[key] = make_json_value<JsonBool>(std::move(_false));
+                    dict.insert_or_assign(std::move(key), make_json_value<JsonBool>(std::move(_false)));
                     });
         } else if (expect(TokenType::NumberLiteral)) {
             auto number = TRY(parse_json_number());
             object.access([&key, &number](JsonObjectDict& dict) {
-                    dict[key] = make_json_value<JsonNumber>(std::move(number));
+                    dict.insert_or_assign(std::move(key), make_json_value<JsonNumber>(std::move(number)));
                     });
         } else if (expect(TokenType::StringLiteral)) {
             auto string_literal = TRY(parse_json_string());
             object.access([&key, &string_literal](JsonObjectDict& dict) {
-                    dict[key] = make_json_value<JsonString>(std::move(string_literal));
+                    dict.insert_or_assign(std::move(key), make_json_value<JsonString>(std::move(string_literal)));
                     });
         } else if (expect(TokenType::OpenCurlyBrace)) {
             auto _object = TRY(parse_json_object());
             object.access([&key, &_object](JsonObjectDict& dict) {
-                    dict[key] = make_json_value<JsonObject>(std::move(_object));
+                    dict.insert_or_assign(std::move(key), make_json_value<JsonObject>(std::move(_object)));
                     });
         } else if (expect(TokenType::OpenBrace)) {
             auto array = TRY(parse_json_array());
             object.access([&key, &array](JsonObjectDict& dict) {
-                    dict[key] = make_json_value<JsonArray>(std::move(array));
+                    dict.insert_or_assign(std::move(key), make_json_value<JsonArray>(std::move(array)));
                     });
         } else if (expect(TokenType::Null)) {
             auto null = TRY(parse_json_null());
             object.access([&key, &null](JsonObjectDict& dict) {
-                    dict[key] = make_json_value<JsonNull>(std::move(null));
+                    dict.insert_or_assign(std::move(key), make_json_value<JsonNull>(std::move(null)));
                     });
         } else {
-            std::string error;
-
-            error.append("ERROR: unexpected token: ");
-            error.append(token_to_string(m_current.type()));
-
-            m_error_stack.push_back(std::move(error));
-
-            return m_error_stack;
+            return error_unexpected_token();
         }
 
         if (expect(TokenType::CloseCurlyBrace))
             break;
         
-        eat_token(TokenType::Comma);
+        TRY(eat_token(TokenType::Comma));
     }
 
-    eat_token(TokenType::CloseCurlyBrace);
-
-    if (m_error_stack.empty())
-        return object;
+    advance();
 
-    return m_error_stack;
+    return object;
 }
 
 auto JsonParser::parse_json_array() -> ErrorOr<JsonArray> {
-    eat_token(TokenType::OpenBrace);
+    JSON_DEPTH();
+
+    TRY(eat_token(TokenType::OpenBrace));
 
     auto array = JsonArray{};
 
+    JSON_STATS(count_node(JsonValueType::JsonArray));
+
     if (expect(TokenType::CloseBrace)) {
         advance();
         return array;
     }
 
     while (true) {
-        if (expect(TokenType::EndOfFile)) {
-            std::string error;
-
-            error.append("ERROR: unexpected end of file");
-
-            m_error_stack.push_back(std::move(error));
-
-            return m_error_stack;
-        }
+        if (expect(TokenType::EndOfFile))
+            return error_unexpected_token();
 
         if (expect(TokenType::BooleanTrue)) {
             auto _true = TRY(parse_json_boolean());
@@ -224,9 +247,9 @@ auto JsonParser::parse_json_array() -> ErrorOr<JsonArray> {
                     elem.push_back(make_json_value<JsonObject>(std::move(_object)));
                     });
         } else if (expect(TokenType::OpenBrace)) {
-            auto array = TRY(parse_json_array());
-            array.access([&array](JsonArrayElements& elem) {
-                    elem.push_back(make_json_value<JsonArray>(std::move(array)));
+            auto _array = TRY(parse_json_array());
+            array.access([&_array](JsonArrayElements& elem) {
+                    elem.push_back(make_json_value<JsonArray>(std::move(_array)));
                     });
         } else if (expect(TokenType::Null)) {
             auto null = TRY(parse_json_null());
@@ -234,46 +257,38 @@ auto JsonParser::parse_json_array() -> ErrorOr<JsonArray> {
                     elem.push_back(make_json_value<JsonNull>(std::move(null)));
                     });
         } else {
-            std::string error;
-
-            error.append("ERROR: unexpected token: ");
-            error.append(token_to_string(m_current.type()));
-
-            m_error_stack.push_back(std::move(error));
-
-            return m_error_stack;
+            return error_unexpected_token();
         }
 
         if (expect(TokenType::CloseBrace))
             break;
         
-        eat_token(TokenType::Comma);
+        TRY(eat_token(TokenType::Comma));
     }
 
-    eat_token(TokenType::CloseBrace);
-
-    if (m_error_stack.empty())
-        return array;
-
-    return m_error_stack;
+    advance();
 
+    return array;
 }
 
 auto JsonParser::parse_json_null() -> ErrorOr<JsonNull> {
-    if (not expect(TokenType::Null)) {
-        std::string error;
-
-        error.append("ERROR: expected: null but got: ");
-        error.append(token_to_string(m_current.type()));
-
-        m_error_stack.push_back(std::move(error));
-
-        return m_error_stack;
-    }
+    if (not expect(TokenType::Null))
+        return error_unexpected_token();
 
     auto result = JsonNull();
 
+    JSON_STATS(count_node(JsonValueType::JsonNull));
+
     advance();
 
     return result;
 }
+
+auto JsonParser::make_key(std::string_view text) const -> JsonKey {
+    if (m_options.key_table)
+        return JsonKey::interned(m_options.key_table->intern(text));
+
+    JSON_STATS(count_string(text.length()));
+
+    return JsonKey(std::string(text));
+}
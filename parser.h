@@ -3,35 +3,58 @@
 #include <vector>
 #include <variant>
 
+#include "error.h"
 #include "lexer.h"
+#include "intern.h"
 #include "jsonval.h"
+#include "validate.h"
 
-using ErrorStack = std::vector<std::string>;
+class JsonLazyDocument;
 
-template <typename T>
-using ErrorOr = std::variant<ErrorStack, T>;
+struct JsonParserOptions {
+    // object keys are interned here and shared with every other document
+    // parsed against the same table, which has to outlive them.
+    StringTable* key_table{nullptr};
 
-#define TRY(...)\
-    ({\
-     auto res = __VA_ARGS__;\
-     if (std::holds_alternative<ErrorStack>(res))\
-        return std::get<0>(res);\
-     std::move(std::get<1>(res));\
-     })\
+    // string values up to this length are interned in key_table as well.
+    std::size_t intern_values_up_to{0};
+};
 
 class JsonParser {
 public:
-    JsonParser(std::string_view input)
-        : m_lexer(input), m_current(m_lexer.get_token()) {}
+    JsonParser(std::string_view input, JsonParserOptions options = {})
+        : m_lexer(input), m_current(m_lexer.get_token()), m_options(options) {}
+
+    // walk a prebuilt structural index, it has to outlive the parser.
+    JsonParser(std::string_view input, const StructuralIndex& index, JsonParserOptions options = {})
+        : m_lexer(input, index), m_current(m_lexer.get_token()), m_options(options) {}
+
+    static auto parse(std::string_view input, const JsonParserOptions& options = {}) -> ErrorOr<JsonObject>;
+
+    // parses straight out of a read-only mapping of the file. neither the
+    // lexer nor the structural index read past the end of their input, so
+    // the mapping needs no padding.
+    static auto parse_file(const std::string& path, const JsonParserOptions& options = {}) -> ErrorOr<JsonObject>;
+
+    // parses nothing up front, values are scanned as they are accessed.
+    // input has to outlive the document.
+    static auto parse_lazy(std::string_view input) -> ErrorOr<JsonLazyDocument>;
 
-    static auto parse(std::string_view) -> ErrorOr<JsonObject>;
+    // checks without parsing, see JsonValidator.
+    static auto validate(std::string_view input, const JsonValidateOptions& options = {}) -> ErrorOr<std::monostate>;
 
 private:
     auto advance() -> void;
 
     auto expect(TokenType type) -> bool;
 
-    auto eat_token(TokenType type) -> void;
+    auto eat_token(TokenType type) -> ErrorOr<std::monostate>;
+
+    // the current token was not what any rule allows.
+    auto error_unexpected_token() const -> JsonError;
+
+    // the top level object and the end of the input right after it.
+    auto parse_document() -> ErrorOr<JsonObject>;
 
     auto parse_json_boolean() -> ErrorOr<JsonBool>;
 
@@ -45,8 +68,13 @@ private:
 
     auto parse_json_null() -> ErrorOr<JsonNull>;
 
+    auto make_key(std::string_view text) const -> JsonKey;
+
 private:
     JsonLexer m_lexer;
     Token m_current;
-    ErrorStack m_error_stack;
+    JsonParserOptions m_options;
+
+    // decoded strings that had escape sequences, reused between tokens.
+    std::string m_scratch;
 };
@@ -0,0 +1,394 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "lexer.h"
+#include "parser.h"
+#include "sax.h"
+
+// Incremental parser for input that arrives in pieces. Every feed() consumes
+// the whole chunk and keeps the lexer and parser state around, so a token may
+// be split anywhere, even in the middle of a string or a number. Only a token
+// that straddles two chunks is buffered, everything else is handed to the
+// handler as a view into the chunk, so memory stays bounded by the longest
+// token and the nesting depth.
+//
+// Events go to the same kind of handler JsonSaxParser drives, which means
+// JsonDomBuilder works here as well.
+template <typename Handler>
+class JsonPushParser {
+public:
+    JsonPushParser(Handler& handler)
+        : m_handler(handler) {}
+
+    auto feed(std::string_view chunk) -> ErrorOr<std::monostate> {
+        if (m_error)
+            return *m_error;
+
+        std::size_t i = 0;
+
+        if (m_partial == Partial::String)
+            i = continue_string(chunk);
+        else if (m_partial == Partial::Scalar)
+            i = continue_scalar(chunk);
+
+        while (i < chunk.length() and m_partial == Partial::None and not m_stopped and not m_error) {
+            const auto c = chunk[i];
+
+            if (is_whitespace(c)) {
+                i++;
+                continue;
+            }
+
+            // a token split across chunks keeps the offset it started at.
+            m_token_offset = m_consumed + i;
+
+            if (c == '"') {
+                i = scan_string(chunk, i + 1);
+            } else if (is_delimiter(c)) {
+                on_token(Token(op_token_type(c)));
+                i++;
+            } else {
+                i = scan_scalar(chunk, i);
+            }
+        }
+
+        m_consumed += chunk.length();
+
+        if (m_error)
+            return *m_error;
+
+        return std::monostate{};
+    }
+
+    // no more input, flushes a trailing scalar and checks that a complete
+    // value was seen.
+    auto finish() -> ErrorOr<std::monostate> {
+        if (not m_error and not m_stopped) {
+            if (m_partial == Partial::String) {
+                on_token(Token(TokenType::Garbage, m_buffer));
+            } else if (m_partial == Partial::Scalar) {
+                m_partial = Partial::None;
+                on_token(lex_token(m_buffer));
+            }
+
+            if (not m_error and m_state != State::Done) {
+                m_token_offset = m_consumed;
+                on_token(Token(TokenType::EndOfFile));
+            }
+        }
+
+        if (m_error)
+            return *m_error;
+
+        return std::monostate{};
+    }
+
+private:
+    enum class Partial {
+        None,
+        String,
+        Scalar,
+    };
+
+    enum class State {
+        Value,
+        ValueOrCloseArray,
+        KeyOrCloseObject,
+        Key,
+        Colon,
+        CommaOrClose,
+        Done,
+    };
+
+    struct Frame {
+        bool is_object;
+        std::size_t count;
+    };
+
+    static auto is_whitespace(char c) -> bool {
+        return c == ' ' or c == '\t' or c == '\n' or c == '\r';
+    }
+
+    static auto is_delimiter(char c) -> bool {
+        return c == '{' or c == '}' or c == '[' or c == ']' or c == ':' or c == ',';
+    }
+
+    static auto op_token_type(char c) -> TokenType {
+        switch (c) {
+        case '{':
+            return TokenType::OpenCurlyBrace;
+        case '}':
+            return TokenType::CloseCurlyBrace;
+        case '[':
+            return TokenType::OpenBrace;
+        case ']':
+            return TokenType::CloseBrace;
+        case ':':
+            return TokenType::Colon;
+        default:
+            break;
+        }
+
+        return TokenType::Comma;
+    }
+
+    // a complete bare scalar or quoted string, anything the lexer does not
+    // consume in one token makes the whole thing garbage. strings go
+    // through the lexer as well so they are checked the same way.
+    static auto lex_token(std::string_view text) -> Token {
+        JsonLexer lexer(text);
+
+        auto token = lexer.get_token();
+
+        if (token.type() == TokenType::Garbage or lexer.get_token().type() != TokenType::EndOfFile)
+            return Token(TokenType::Garbage, text);
+
+        return token;
+    }
+
+    // offset of the closing quote at or after start, or npos. tracks a
+    // trailing backslash so an escape split across chunks is honoured.
+    auto find_closing_quote(std::string_view chunk, std::size_t start) -> std::size_t {
+        for (auto i = start; i < chunk.length(); i++) {
+            if (m_escape_pending) {
+                m_escape_pending = false;
+            } else if (chunk[i] == '\\') {
+                m_escape_pending = true;
+            } else if (chunk[i] == '"') {
+                return i;
+            }
+        }
+
+        return std::string_view::npos;
+    }
+
+    auto scan_string(std::string_view chunk, std::size_t start) -> std::size_t {
+        const auto end = find_closing_quote(chunk, start);
+
+        // both quotes are kept, the literal is lexed as a whole.
+        if (end == std::string_view::npos) {
+            m_partial = Partial::String;
+            m_buffer.clear();
+            m_buffer.append(chunk.substr(start - 1));
+
+            return chunk.length();
+        }
+
+        // the whole literal is inside this chunk, no copy needed.
+        on_token(lex_token(chunk.substr(start - 1, end - start + 2)));
+
+        return end + 1;
+    }
+
+    auto continue_string(std::string_view chunk) -> std::size_t {
+        const auto end = find_closing_quote(chunk, 0);
+
+        if (end == std::string_view::npos) {
+            m_buffer.append(chunk);
+
+            return chunk.length();
+        }
+
+        m_buffer.append(chunk.substr(0, end + 1));
+        m_partial = Partial::None;
+
+        on_token(lex_token(m_buffer));
+
+        return end + 1;
+    }
+
+    auto scan_scalar(std::string_view chunk, std::size_t start) -> std::size_t {
+        auto end = start;
+
+        while (end < chunk.length() and not is_whitespace(chunk[end]) and not is_delimiter(chunk[end]) and chunk[end] != '"')
+            end++;
+
+        if (end == chunk.length()) {
+            m_partial = Partial::Scalar;
+            m_buffer.clear();
+            m_buffer.append(chunk.substr(start));
+
+            return chunk.length();
+        }
+
+        on_token(lex_token(chunk.substr(start, end - start)));
+
+        return end;
+    }
+
+    auto continue_scalar(std::string_view chunk) -> std::size_t {
+        std::size_t end = 0;
+
+        while (end < chunk.length() and not is_whitespace(chunk[end]) and not is_delimiter(chunk[end]) and chunk[end] != '"')
+            end++;
+
+        m_buffer.append(chunk.substr(0, end));
+
+        if (end == chunk.length())
+            return end;
+
+        m_partial = Partial::None;
+
+        on_token(lex_token(m_buffer));
+
+        return end;
+    }
+
+    auto error_unexpected_token(const Token& token) -> void {
+        m_error = JsonError::unexpected_token(token.type(), m_token_offset);
+    }
+
+    auto emit(bool keep_going) -> void {
+        if (not keep_going)
+            m_stopped = true;
+    }
+
+    auto after_value() -> void {
+        if (m_stack.empty()) {
+            m_state = State::Done;
+            return;
+        }
+
+        m_stack.back().count++;
+        m_state = State::CommaOrClose;
+    }
+
+    auto close_container(const Token& token) -> void {
+        const auto& frame = m_stack.back();
+
+        if (frame.is_object != (token.type() == TokenType::CloseCurlyBrace)) {
+            error_unexpected_token(token);
+            return;
+        }
+
+        emit(frame.is_object ? m_handler.on_end_object(frame.count) : m_handler.on_end_array(frame.count));
+
+        m_stack.pop_back();
+
+        after_value();
+    }
+
+    auto on_value(const Token& token) -> void {
+        switch (token.type()) {
+        case TokenType::BooleanTrue:
+            emit(m_handler.on_bool(true));
+            break;
+        case TokenType::BooleanFalse:
+            emit(m_handler.on_bool(false));
+            break;
+        case TokenType::Null:
+            emit(m_handler.on_null());
+            break;
+        case TokenType::NumberLiteral: {
+            const auto result = emit_number(m_handler, token.lexeme());
+
+            if (not result) {
+                m_error = JsonError(JsonErrorCode::NumberOutOfRange, m_token_offset, token.lexeme());
+                return;
+            }
+
+            emit(*result);
+            break;
+        }
+        case TokenType::StringLiteral:
+            emit(m_handler.on_string(token.text(m_scratch)));
+            break;
+        case TokenType::OpenCurlyBrace:
+            emit(m_handler.on_start_object());
+            m_stack.push_back(Frame{true, 0});
+            m_state = State::KeyOrCloseObject;
+            return;
+        case TokenType::OpenBrace:
+            emit(m_handler.on_start_array());
+            m_stack.push_back(Frame{false, 0});
+            m_state = State::ValueOrCloseArray;
+            return;
+        default:
+            error_unexpected_token(token);
+            return;
+        }
+
+        after_value();
+    }
+
+    auto on_token(const Token& token) -> void {
+        switch (m_state) {
+        case State::ValueOrCloseArray:
+            if (token.type() == TokenType::CloseBrace) {
+                close_container(token);
+                return;
+            }
+
+            on_value(token);
+            return;
+        case State::Value:
+            on_value(token);
+            return;
+        case State::KeyOrCloseObject:
+            if (token.type() == TokenType::CloseCurlyBrace) {
+                close_container(token);
+                return;
+            }
+
+            [[fallthrough]];
+        case State::Key:
+            if (token.type() != TokenType::StringLiteral) {
+                error_unexpected_token(token);
+                return;
+            }
+
+            emit(m_handler.on_key(token.text(m_scratch)));
+            m_state = State::Colon;
+            return;
+        case State::Colon:
+            if (token.type() != TokenType::Colon) {
+                error_unexpected_token(token);
+                return;
+            }
+
+            m_state = State::Value;
+            return;
+        case State::CommaOrClose:
+            if (token.type() == TokenType::Comma) {
+                m_state = m_stack.back().is_object ? State::Key : State::Value;
+                return;
+            }
+
+            if (token.type() == TokenType::CloseCurlyBrace or token.type() == TokenType::CloseBrace) {
+                close_container(token);
+                return;
+            }
+
+            error_unexpected_token(token);
+            return;
+        case State::Done:
+            error_unexpected_token(token);
+            return;
+        }
+    }
+
+private:
+    Handler& m_handler;
+
+    Partial m_partial{Partial::None};
+    bool m_escape_pending{false};
+    std::string m_buffer;
+
+    State m_state{State::Value};
+    std::vector<Frame> m_stack;
+
+    // bytes of the chunks before the current one, and where the token being
+    // scanned starts in the whole input.
+    std::size_t m_consumed{0};
+    std::size_t m_token_offset{0};
+
+    std::optional<JsonError> m_error;
+    bool m_stopped{false};
+
+    std::string m_scratch;
+};
@@ -0,0 +1,472 @@
+#include <algorithm>
+#include <charconv>
+
+#include "query.h"
+
+namespace {
+
+// reason has to be a string literal, position is where in expression the
+// problem was found.
+auto query_error(std::string_view expression, std::string_view reason, std::size_t position) -> JsonError {
+    return JsonError::invalid_query(expression, reason, position);
+}
+
+auto parse_integer(std::string_view text) -> std::optional<std::int64_t> {
+    std::int64_t result = 0;
+
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.length(), result);
+
+    if (error != std::errc{} or end != text.data() + text.length())
+        return std::nullopt;
+
+    return result;
+}
+
+// an array index as json pointer spells it, digits without leading zeros.
+auto pointer_index(std::string_view token) -> std::optional<std::int64_t> {
+    if (token.empty() or (token.length() > 1 and token[0] == '0'))
+        return std::nullopt;
+
+    for (const auto c : token) {
+        if (c < '0' or c > '9')
+            return std::nullopt;
+    }
+
+    return parse_integer(token);
+}
+
+// indices a slice selects out of an array of the given size.
+auto slice_indices(const QueryStep& step, std::size_t size) -> std::vector<std::size_t> {
+    const auto length = static_cast<std::int64_t>(size);
+
+    const auto normalize = [length](std::int64_t index, std::int64_t low, std::int64_t high) {
+        if (index < 0)
+            index += length;
+
+        return std::clamp(index, low, high);
+    };
+
+    std::vector<std::size_t> result;
+
+    if (step.step > 0) {
+        const auto start = step.start ? normalize(*step.start, 0, length) : 0;
+        const auto end = step.end ? normalize(*step.end, 0, length) : length;
+
+        for (auto i = start; i < end; i += step.step)
+            result.push_back(static_cast<std::size_t>(i));
+    } else {
+        const auto start = step.start ? normalize(*step.start, -1, length - 1) : length - 1;
+        const auto end = step.end ? normalize(*step.end, -1, length - 1) : -1;
+
+        for (auto i = start; i > end; i += step.step)
+            result.push_back(static_cast<std::size_t>(i));
+    }
+
+    return result;
+}
+
+// how evaluate walks a parsed tree.
+struct TreeNodes {
+    using Node = const JsonValue*;
+
+    static auto is_object(Node node) -> bool {
+        return node->get_type() == JsonValueType::JsonObject;
+    }
+
+    static auto is_array(Node node) -> bool {
+        return node->get_type() == JsonValueType::JsonArray;
+    }
+
+    static auto member(Node node, std::string_view key) -> ErrorOr<std::optional<Node>> {
+        std::optional<Node> result;
+
+        static_cast<const JsonObject*>(node)->access([&](const JsonObjectDict& dict) {
+                const auto member = dict.find(key);
+
+                if (member != dict.end())
+                    result = member->second.get();
+                });
+
+        return result;
+    }
+
+    static auto element(Node node, std::size_t index) -> ErrorOr<std::optional<Node>> {
+        std::optional<Node> result;
+
+        static_cast<const JsonArray*>(node)->access([&](const JsonArrayElements& elements) {
+                if (index < elements.size())
+                    result = elements[index].get();
+                });
+
+        return result;
+    }
+
+    static auto size(Node node) -> ErrorOr<std::size_t> {
+        std::size_t result = 0;
+
+        static_cast<const JsonArray*>(node)->access([&](const JsonArrayElements& elements) {
+                result = elements.size();
+                });
+
+        return result;
+    }
+
+    static auto children(Node node) -> ErrorOr<std::vector<Node>> {
+        std::vector<Node> result;
+
+        if (is_object(node)) {
+            static_cast<const JsonObject*>(node)->access([&](const JsonObjectDict& dict) {
+                    for (const auto& [key, value] : dict)
+                        result.push_back(value.get());
+                    });
+        } else if (is_array(node)) {
+            static_cast<const JsonArray*>(node)->access([&](const JsonArrayElements& elements) {
+                    for (const auto& element : elements)
+                        result.push_back(element.get());
+                    });
+        }
+
+        return result;
+    }
+};
+
+// how evaluate walks the raw text.
+struct LazyNodes {
+    using Node = JsonLazyValue;
+
+    static auto is_object(Node node) -> bool {
+        return node.get_type() == JsonValueType::JsonObject;
+    }
+
+    static auto is_array(Node node) -> bool {
+        return node.get_type() == JsonValueType::JsonArray;
+    }
+
+    static auto member(Node node, std::string_view key) -> ErrorOr<std::optional<Node>> {
+        return node.try_find(key);
+    }
+
+    static auto element(Node node, std::size_t index) -> ErrorOr<std::optional<Node>> {
+        return node.try_at(index);
+    }
+
+    static auto size(Node node) -> ErrorOr<std::size_t> {
+        return node.size();
+    }
+
+    static auto children(Node node) -> ErrorOr<std::vector<Node>> {
+        if (is_array(node))
+            return node.elements();
+
+        std::vector<Node> result;
+
+        if (is_object(node)) {
+            const auto members = TRY(node.members());
+
+            for (const auto& [key, value] : members)
+                result.push_back(value);
+        }
+
+        return result;
+    }
+};
+
+template <typename Nodes>
+auto collect_descendants(typename Nodes::Node node, std::vector<typename Nodes::Node>& out) -> ErrorOr<std::monostate> {
+    out.push_back(node);
+
+    const auto children = TRY(Nodes::children(node));
+
+    for (const auto& child : children)
+        TRY(collect_descendants<Nodes>(child, out));
+
+    return std::monostate{};
+}
+
+template <typename Nodes>
+auto apply_step(const QueryStep& step, typename Nodes::Node node, std::vector<typename Nodes::Node>& out) -> ErrorOr<std::monostate> {
+    const auto push = [&out](const std::optional<typename Nodes::Node>& result) {
+        if (result)
+            out.push_back(*result);
+    };
+
+    switch (step.kind) {
+    case QueryStep::Kind::Name:
+        if (Nodes::is_object(node))
+            push(TRY(Nodes::member(node, step.name)));
+        break;
+    case QueryStep::Kind::Token:
+        if (Nodes::is_object(node))
+            push(TRY(Nodes::member(node, step.name)));
+        else if (Nodes::is_array(node) and step.has_index)
+            push(TRY(Nodes::element(node, static_cast<std::size_t>(step.index))));
+        break;
+    case QueryStep::Kind::Index: {
+        if (not Nodes::is_array(node))
+            break;
+
+        auto index = step.index;
+
+        // only a negative index needs the size, the rest stops at the element.
+        if (index < 0)
+            index += static_cast<std::int64_t>(TRY(Nodes::size(node)));
+
+        if (index >= 0)
+            push(TRY(Nodes::element(node, static_cast<std::size_t>(index))));
+
+        break;
+    }
+    case QueryStep::Kind::Wildcard: {
+        const auto children = TRY(Nodes::children(node));
+
+        out.insert(out.end(), children.begin(), children.end());
+
+        break;
+    }
+    case QueryStep::Kind::Slice: {
+        if (not Nodes::is_array(node))
+            break;
+
+        const auto elements = TRY(Nodes::children(node));
+
+        for (const auto index : slice_indices(step, elements.size()))
+            out.push_back(elements[index]);
+
+        break;
+    }
+    case QueryStep::Kind::Descendants:
+        TRY(collect_descendants<Nodes>(node, out));
+        break;
+    }
+
+    return std::monostate{};
+}
+
+template <typename Nodes>
+auto evaluate_steps(const std::vector<QueryStep>& steps, typename Nodes::Node root) -> ErrorOr<std::vector<typename Nodes::Node>> {
+    std::vector<typename Nodes::Node> current{root};
+    std::vector<typename Nodes::Node> next;
+
+    for (const auto& step : steps) {
+        next.clear();
+
+        for (const auto& node : current)
+            TRY(apply_step<Nodes>(step, node, next));
+
+        std::swap(current, next);
+
+        if (current.empty())
+            break;
+    }
+
+    return current;
+}
+
+// the name or index inside [...], position starts after the '['.
+auto compile_bracket(std::string_view path, std::size_t& position) -> ErrorOr<QueryStep> {
+    const auto close = path.find(']', position);
+
+    if (path[position] == '\'' or path[position] == '"') {
+        const auto quote = path[position++];
+
+        std::string name;
+
+        while (position < path.length() and path[position] != quote) {
+            if (path[position] == '\\' and position + 1 < path.length())
+                position++;
+
+            name.push_back(path[position++]);
+        }
+
+        if (position + 1 >= path.length() or path[position + 1] != ']')
+            return query_error(path, "unterminated name", position);
+
+        position += 2;
+
+        return QueryStep{.kind = QueryStep::Kind::Name, .name = std::move(name)};
+    }
+
+    if (close == std::string_view::npos)
+        return query_error(path, "missing ']'", position);
+
+    const auto inside = path.substr(position, close - position);
+
+    position = close + 1;
+
+    if (inside == "*")
+        return QueryStep{.kind = QueryStep::Kind::Wildcard};
+
+    if (inside.find(':') == std::string_view::npos) {
+        const auto index = parse_integer(inside);
+
+        if (not index)
+            return query_error(path, "invalid index", position);
+
+        return QueryStep{.kind = QueryStep::Kind::Index, .index = *index};
+    }
+
+    QueryStep step{.kind = QueryStep::Kind::Slice};
+
+    std::optional<std::int64_t>* parts[] = {&step.start, &step.end, nullptr};
+    std::size_t part = 0;
+    std::size_t begin = 0;
+
+    for (std::size_t i = 0; i <= inside.length(); i++) {
+        if (i < inside.length() and inside[i] != ':')
+            continue;
+
+        if (part > 2)
+            return query_error(path, "invalid slice", position);
+
+        const auto text = inside.substr(begin, i - begin);
+
+        if (not text.empty()) {
+            const auto value = parse_integer(text);
+
+            if (not value)
+                return query_error(path, "invalid slice", position);
+
+            if (part < 2)
+                *parts[part] = *value;
+            else
+                step.step = *value;
+        }
+
+        part++;
+        begin = i + 1;
+    }
+
+    if (step.step == 0)
+        return query_error(path, "slice step cannot be zero", position);
+
+    return step;
+}
+
+}
+
+auto JsonQuery::compile(std::string_view expression) -> ErrorOr<JsonQuery> {
+    if (expression.empty() or expression[0] == '/')
+        return compile_pointer(expression);
+
+    if (expression[0] == '$')
+        return compile_path(expression);
+
+    return query_error(expression, "expected a json pointer or a json path", 0);
+}
+
+auto JsonQuery::compile_pointer(std::string_view pointer) -> ErrorOr<JsonQuery> {
+    std::vector<QueryStep> steps;
+
+    if (pointer.empty())
+        return JsonQuery(std::move(steps));
+
+    if (pointer[0] != '/')
+        return query_error(pointer, "a json pointer starts with '/'", 0);
+
+    std::size_t position = 1;
+
+    while (true) {
+        const auto slash = pointer.find('/', position);
+        const auto token = pointer.substr(position, slash == std::string_view::npos ? std::string_view::npos : slash - position);
+
+        QueryStep step{.kind = QueryStep::Kind::Token};
+
+        for (std::size_t i = 0; i < token.length(); i++) {
+            if (token[i] != '~') {
+                step.name.push_back(token[i]);
+                continue;
+            }
+
+            if (i + 1 == token.length() or (token[i + 1] != '0' and token[i + 1] != '1'))
+                return query_error(pointer, "'~' has to be followed by '0' or '1'", position + i);
+
+            step.name.push_back(token[++i] == '0' ? '~' : '/');
+        }
+
+        if (const auto index = pointer_index(token)) {
+            step.index = *index;
+            step.has_index = true;
+        }
+
+        steps.push_back(std::move(step));
+
+        if (slash == std::string_view::npos)
+            break;
+
+        position = slash + 1;
+    }
+
+    return JsonQuery(std::move(steps));
+}
+
+auto JsonQuery::compile_path(std::string_view path) -> ErrorOr<JsonQuery> {
+    if (path.empty() or path[0] != '$')
+        return query_error(path, "a json path starts with '$'", 0);
+
+    std::vector<QueryStep> steps;
+    std::size_t position = 1;
+
+    while (position < path.length()) {
+        if (path.substr(position, 2) == "..") {
+            steps.push_back(QueryStep{.kind = QueryStep::Kind::Descendants});
+
+            // "..name" reads like ".name", "..[0]" like "[0]".
+            position += position + 2 < path.length() and path[position + 2] == '[' ? 2 : 1;
+        }
+
+        if (path[position] == '[') {
+            position++;
+
+            if (position >= path.length())
+                return query_error(path, "missing ']'", position);
+
+            steps.push_back(TRY(compile_bracket(path, position)));
+
+            continue;
+        }
+
+        if (path[position] != '.')
+            return query_error(path, "expected '.' or '['", position);
+
+        const auto start = ++position;
+
+        while (position < path.length() and path[position] != '.' and path[position] != '[')
+            position++;
+
+        const auto name = path.substr(start, position - start);
+
+        if (name.empty())
+            return query_error(path, "empty name", start);
+
+        if (name == "*")
+            steps.push_back(QueryStep{.kind = QueryStep::Kind::Wildcard});
+        else
+            steps.push_back(QueryStep{.kind = QueryStep::Kind::Name, .name = std::string(name)});
+    }
+
+    if (not steps.empty() and steps.back().kind == QueryStep::Kind::Descendants)
+        return query_error(path, "'..' has to be followed by a selector", path.length());
+
+    return JsonQuery(std::move(steps));
+}
+
+auto JsonQuery::evaluate(const JsonValue& root) const -> std::vector<const JsonValue*> {
+    // walking a tree cannot fail.
+    return std::get<1>(evaluate_steps<TreeNodes>(m_steps, &root));
+}
+
+auto JsonQuery::evaluate(const JsonLazyValue& root) const -> ErrorOr<std::vector<JsonLazyValue>> {
+    return evaluate_steps<LazyNodes>(m_steps, root);
+}
+
+auto JsonQuery::evaluate(std::string_view input) const -> ErrorOr<std::vector<JsonLazyValue>> {
+    const auto document = TRY(JsonLazyDocument::parse(input));
+
+    return evaluate(document.root());
+}
+
+auto JsonQuery::first(const JsonValue& root) const -> const JsonValue* {
+    const auto matches = evaluate(root);
+
+    return matches.empty() ? nullptr : matches.front();
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "jsonval.h"
+#include "lazy.h"
+#include "parser.h"
+
+struct QueryStep {
+    enum class Kind {
+        // object member, from a json path name or a quoted bracket.
+        Name,
+        // array element, negative indices count from the end.
+        Index,
+        // json pointer reference token, a member of an object or, if it
+        // is a valid array index, an element of an array.
+        Token,
+        // every child of an object or array.
+        Wildcard,
+        // python style array slice.
+        Slice,
+        // the node and all of its descendants, the next step applies to
+        // each of them.
+        Descendants,
+    };
+
+    Kind kind;
+
+    std::string name{};
+    std::int64_t index{0};
+    bool has_index{false};
+
+    std::optional<std::int64_t> start{};
+    std::optional<std::int64_t> end{};
+    std::int64_t step{1};
+};
+
+// A JSON Pointer (RFC 6901) or JSON Path expression compiled into a list of
+// steps. Compile once and evaluate against as many documents as needed,
+// either against a parsed tree or straight against the raw text, where
+// only the parts of the input the query walks through are scanned.
+//
+// The supported JSON Path subset is $, .name, ['name'], [index], [*], .*,
+// [start:end:step] and recursive descent with .. in front of any of them.
+// Keys are compared decoded, the same on a tree and on the raw text.
+class JsonQuery {
+public:
+    // a json pointer if the expression is empty or starts with '/', a json
+    // path if it starts with '$'.
+    static auto compile(std::string_view expression) -> ErrorOr<JsonQuery>;
+
+    static auto compile_pointer(std::string_view pointer) -> ErrorOr<JsonQuery>;
+
+    static auto compile_path(std::string_view path) -> ErrorOr<JsonQuery>;
+
+    // every match, in document order. the pointers are only valid as long
+    // as the tree is.
+    auto evaluate(const JsonValue& root) const -> std::vector<const JsonValue*>;
+
+    auto evaluate(const JsonLazyValue& root) const -> ErrorOr<std::vector<JsonLazyValue>>;
+
+    // parses and queries in one pass, input has to outlive the results.
+    auto evaluate(std::string_view input) const -> ErrorOr<std::vector<JsonLazyValue>>;
+
+    // first match, nullptr if there is none.
+    auto first(const JsonValue& root) const -> const JsonValue*;
+
+    auto steps() const -> const std::vector<QueryStep>& { return m_steps; }
+
+private:
+    JsonQuery(std::vector<QueryStep> steps)
+        : m_steps(std::move(steps)) {}
+
+private:
+    std::vector<QueryStep> m_steps;
+};
@@ -0,0 +1,99 @@
+#include "sax.h"
+
+auto JsonDomBuilder::on_null() -> bool {
+    return add_value(make_json_value<JsonNull>());
+}
+
+auto JsonDomBuilder::on_bool(bool boolean) -> bool {
+    return add_value(make_json_value<JsonBool>(boolean));
+}
+
+auto JsonDomBuilder::on_number(double number) -> bool {
+    return add_value(make_json_value<JsonNumber>(number));
+}
+
+auto JsonDomBuilder::on_int64(std::int64_t number) -> bool {
+    return add_value(make_json_value<JsonNumber>(number));
+}
+
+auto JsonDomBuilder::on_uint64(std::uint64_t number) -> bool {
+    return add_value(make_json_value<JsonNumber>(number));
+}
+
+auto JsonDomBuilder::on_string(std::string_view string) -> bool {
+    if (m_options.key_table and string.length() <= m_options.intern_values_up_to)
+        return add_value(make_json_value<JsonString>(JsonString::interned(m_options.key_table->intern(string))));
+
+    JSON_STATS(count_string(string.length()));
+
+    return add_value(make_json_value<JsonString>(std::string(string)));
+}
+
+auto JsonDomBuilder::on_key(std::string_view key) -> bool {
+    if (m_options.key_table)
+        m_keys.push_back(JsonKey::interned(m_options.key_table->intern(key)));
+    else
+        m_keys.emplace_back(std::string(key));
+
+    if (not m_options.key_table)
+        JSON_STATS(count_string(key.length()));
+
+    return true;
+}
+
+auto JsonDomBuilder::on_start_object() -> bool {
+    m_stack.push_back(make_json_value<JsonObject>(JsonObject{}));
+
+    return true;
+}
+
+auto JsonDomBuilder::on_end_object(std::size_t) -> bool {
+    auto object = std::move(m_stack.back());
+
+    m_stack.pop_back();
+
+    return add_value(std::move(object));
+}
+
+auto JsonDomBuilder::on_start_array() -> bool {
+    m_stack.push_back(make_json_value<JsonArray>(JsonArray{}));
+
+    return true;
+}
+
+auto JsonDomBuilder::on_end_array(std::size_t) -> bool {
+    auto array = std::move(m_stack.back());
+
+    m_stack.pop_back();
+
+    return add_value(std::move(array));
+}
+
+auto JsonDomBuilder::result() -> std::shared_ptr<JsonValue> {
+    return m_result;
+}
+
+auto JsonDomBuilder::add_value(std::shared_ptr<JsonValue> value) -> bool {
+    JSON_STATS(count_node(value->get_type()));
+
+    if (m_stack.empty()) {
+        m_result = std::move(value);
+        return true;
+    }
+
+    auto& parent = m_stack.back();
+
+    if (parent->get_type() == JsonValueType::JsonObject) {
+        static_cast<JsonObject*>(parent.get())->access([this, &value](JsonObjectDict& dict) {
+                dict.insert_or_assign(std::move(m_keys.back()), std::move(value));
+                });
+
+        m_keys.pop_back();
+    } else {
+        static_cast<JsonArray*>(parent.get())->access([&value](JsonArrayElements& elements) {
+                elements.push_back(std::move(value));
+                });
+    }
+
+    return true;
+}
@@ -0,0 +1,316 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "lexer.h"
+#include "jsonval.h"
+#include "number.h"
+#include "parser.h"
+#include "stats.h"
+
+// Default callbacks for JsonSaxParser, a handler derives from this and hides
+// the ones it cares about. Every callback returns whether parsing should go
+// on, returning false stops the parse early without an error. Strings and
+// keys come with their escape sequences decoded, as views into the input or
+// into a scratch buffer, and are only valid during the call.
+//
+// A handler that also declares on_int64(std::int64_t) and
+// on_uint64(std::uint64_t) gets integral literals with their exact value.
+class JsonSaxHandler {
+public:
+    auto on_null() -> bool { return true; }
+
+    auto on_bool(bool) -> bool { return true; }
+
+    auto on_number(double) -> bool { return true; }
+
+    auto on_string(std::string_view) -> bool { return true; }
+
+    auto on_key(std::string_view) -> bool { return true; }
+
+    auto on_start_object() -> bool { return true; }
+
+    auto on_end_object(std::size_t) -> bool { return true; }
+
+    auto on_start_array() -> bool { return true; }
+
+    auto on_end_array(std::size_t) -> bool { return true; }
+};
+
+// Hands a number literal to the handler in the most exact form it takes:
+// on_int64 or on_uint64 when the literal is integral and the handler has
+// them, on_number otherwise. nullopt if the literal does not fit a double.
+template <typename Handler>
+auto emit_number(Handler& handler, std::string_view literal) -> std::optional<bool> {
+    const auto number = parse_number_value(literal);
+
+    if (not number)
+        return std::nullopt;
+
+    if (const auto* integer = std::get_if<std::int64_t>(&*number)) {
+        if constexpr (requires { handler.on_int64(*integer); })
+            return handler.on_int64(*integer);
+        else
+            return handler.on_number(static_cast<double>(*integer));
+    }
+
+    if (const auto* integer = std::get_if<std::uint64_t>(&*number)) {
+        if constexpr (requires { handler.on_uint64(*integer); })
+            return handler.on_uint64(*integer);
+        else
+            return handler.on_number(static_cast<double>(*integer));
+    }
+
+    return handler.on_number(std::get<double>(*number));
+}
+
+// Event based parser, drives a handler straight from the lexer without
+// building any JsonValue. The handler is a template parameter so the calls
+// are resolved, and usually inlined, at compile time.
+template <typename Handler>
+class JsonSaxParser {
+public:
+    JsonSaxParser(std::string_view input, const StructuralIndex& index, Handler& handler)
+        : m_lexer(input, index), m_current(m_lexer.get_token()), m_handler(handler) {}
+
+    static auto parse(std::string_view input, Handler& handler) -> ErrorOr<std::monostate> {
+        if (input.length() > StructuralIndex::max_input_size)
+            return JsonError(JsonErrorCode::InputTooLarge, 0);
+
+        JSON_STATS(bytes_scanned += input.length());
+
+        const auto index = StructuralIndex::build(input);
+
+        JSON_PHASE(JsonPhase::Parse);
+
+        JsonSaxParser parser(input, index, handler);
+
+        return parser.parse();
+    }
+
+    auto parse() -> ErrorOr<std::monostate> {
+        parse_value();
+
+        if (not m_stopped and not m_error and not expect(TokenType::EndOfFile))
+            error_unexpected_token();
+
+        if (m_error)
+            return *m_error;
+
+        return std::monostate{};
+    }
+
+private:
+    auto advance() -> void {
+        if (m_current.type() == TokenType::EndOfFile)
+            return;
+
+        m_current = m_lexer.get_token();
+    }
+
+    auto expect(TokenType type) -> bool {
+        return m_current.type() == type;
+    }
+
+    auto eat_token(TokenType type) -> bool {
+        if (not expect(type)) {
+            m_error = JsonError::expected_token(type, m_current.type(), m_lexer.token_offset());
+            return false;
+        }
+
+        advance();
+
+        return true;
+    }
+
+    auto error_unexpected_token() -> void {
+        m_error = JsonError::unexpected_token(m_current.type(), m_lexer.token_offset());
+    }
+
+    auto error_number_out_of_range() -> void {
+        m_error = JsonError(JsonErrorCode::NumberOutOfRange, m_lexer.token_offset(), m_current.lexeme());
+    }
+
+    // false once the handler asked to stop, the result is then discarded.
+    auto emit(bool keep_going) -> bool {
+        if (not keep_going)
+            m_stopped = true;
+
+        return keep_going;
+    }
+
+    auto parse_value() -> bool {
+        bool keep_going = true;
+
+        switch (m_current.type()) {
+        case TokenType::BooleanTrue:
+            keep_going = m_handler.on_bool(true);
+            break;
+        case TokenType::BooleanFalse:
+            keep_going = m_handler.on_bool(false);
+            break;
+        case TokenType::Null:
+            keep_going = m_handler.on_null();
+            break;
+        case TokenType::NumberLiteral: {
+            const auto result = emit_number(m_handler, m_current.lexeme());
+
+            if (not result) {
+                error_number_out_of_range();
+                return false;
+            }
+
+            keep_going = *result;
+            break;
+        }
+        case TokenType::StringLiteral:
+            keep_going = m_handler.on_string(m_current.text(m_scratch));
+            break;
+        case TokenType::OpenCurlyBrace:
+            return parse_object();
+        case TokenType::OpenBrace:
+            return parse_array();
+        default:
+            error_unexpected_token();
+            return false;
+        }
+
+        if (not emit(keep_going))
+            return false;
+
+        advance();
+
+        return true;
+    }
+
+    auto parse_object() -> bool {
+        JSON_DEPTH();
+
+        std::size_t count = 0;
+
+        if (not emit(m_handler.on_start_object()))
+            return false;
+
+        advance();
+
+        if (not expect(TokenType::CloseCurlyBrace)) {
+            while (true) {
+                if (not expect(TokenType::StringLiteral))
+                    return eat_token(TokenType::StringLiteral);
+
+                if (not emit(m_handler.on_key(m_current.text(m_scratch))))
+                    return false;
+
+                advance();
+
+                if (not eat_token(TokenType::Colon) or not parse_value())
+                    return false;
+
+                count++;
+
+                if (expect(TokenType::CloseCurlyBrace))
+                    break;
+
+                if (not eat_token(TokenType::Comma))
+                    return false;
+            }
+        }
+
+        if (not emit(m_handler.on_end_object(count)))
+            return false;
+
+        advance();
+
+        return true;
+    }
+
+    auto parse_array() -> bool {
+        JSON_DEPTH();
+
+        std::size_t count = 0;
+
+        if (not emit(m_handler.on_start_array()))
+            return false;
+
+        advance();
+
+        if (not expect(TokenType::CloseBrace)) {
+            while (true) {
+                if (not parse_value())
+                    return false;
+
+                count++;
+
+                if (expect(TokenType::CloseBrace))
+                    break;
+
+                if (not eat_token(TokenType::Comma))
+                    return false;
+            }
+        }
+
+        if (not emit(m_handler.on_end_array(count)))
+            return false;
+
+        advance();
+
+        return true;
+    }
+
+private:
+    JsonLexer m_lexer;
+    Token m_current;
+    Handler& m_handler;
+    // the first error ends the parse, there is never more than one.
+    std::optional<JsonError> m_error;
+    bool m_stopped{false};
+
+    std::string m_scratch;
+};
+
+// Handler that builds the usual shared_ptr<JsonValue> tree.
+class JsonDomBuilder : public JsonSaxHandler {
+public:
+    JsonDomBuilder(JsonParserOptions options = {})
+        : m_options(options) {}
+
+    auto on_null() -> bool;
+
+    auto on_bool(bool boolean) -> bool;
+
+    auto on_number(double number) -> bool;
+
+    auto on_int64(std::int64_t number) -> bool;
+
+    auto on_uint64(std::uint64_t number) -> bool;
+
+    auto on_string(std::string_view string) -> bool;
+
+    auto on_key(std::string_view key) -> bool;
+
+    auto on_start_object() -> bool;
+
+    auto on_end_object(std::size_t count) -> bool;
+
+    auto on_start_array() -> bool;
+
+    auto on_end_array(std::size_t count) -> bool;
+
+    // the finished document, null until a whole value was parsed.
+    auto result() -> std::shared_ptr<JsonValue>;
+
+private:
+    auto add_value(std::shared_ptr<JsonValue> value) -> bool;
+
+private:
+    std::vector<std::shared_ptr<JsonValue>> m_stack;
+    std::vector<JsonKey> m_keys;
+    std::shared_ptr<JsonValue> m_result;
+    JsonParserOptions m_options;
+};
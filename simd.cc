@@ -0,0 +1,32 @@
+#include "simd.h"
+
+auto simd_level_to_string(SimdLevel level) -> std::string_view {
+    switch (level) {
+    case SimdLevel::Scalar:
+        return "scalar";
+    case SimdLevel::Sse2:
+        return "sse2";
+    case SimdLevel::Avx2:
+        return "avx2";
+    }
+
+    return "unknown";
+}
+
+auto detect_simd_level() -> SimdLevel {
+#if defined(__x86_64__)
+    static const auto level = [] {
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx2"))
+            return SimdLevel::Avx2;
+
+        // sse2 is part of the x86-64 baseline.
+        return SimdLevel::Sse2;
+    }();
+
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
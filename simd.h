@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string_view>
+
+enum class SimdLevel {
+    Scalar,
+    Sse2,
+    Avx2,
+};
+
+auto simd_level_to_string(SimdLevel) -> std::string_view;
+
+// the widest instruction set the running cpu supports, detected once.
+auto detect_simd_level() -> SimdLevel;
@@ -0,0 +1,175 @@
+#include <atomic>
+
+#include "stats.h"
+
+namespace {
+
+thread_local ParseStats* installed_stats = nullptr;
+thread_local JsonTrace* installed_trace = nullptr;
+
+// small, stable thread ids read better in a trace viewer than hashed
+// std::thread::ids.
+auto current_thread_id() -> std::uint64_t {
+    static std::atomic<std::uint64_t> next_id{1};
+    thread_local const auto id = next_id.fetch_add(1, std::memory_order_relaxed);
+
+    return id;
+}
+
+}
+
+auto phase_to_string(JsonPhase phase) -> std::string_view {
+    switch (phase) {
+    case JsonPhase::Index:
+        return "index";
+    case JsonPhase::Validate:
+        return "validate";
+    case JsonPhase::Parse:
+        return "parse";
+    case JsonPhase::Serialize:
+        return "serialize";
+    }
+
+    return "unknown";
+}
+
+auto ParseStats::reset() -> void {
+    *this = ParseStats{};
+}
+
+auto ParseStats::write(JsonWriter& writer) const -> void {
+    writer.start_object();
+
+    writer.write_key("tokens");
+    writer.start_object();
+
+    for (std::size_t i = 0; i < token_type_count; i++) {
+        writer.write_key(token_to_string(static_cast<TokenType>(i)));
+        writer.write_uint64(tokens[i]);
+    }
+
+    writer.end_object();
+
+    writer.write_key("nodes");
+    writer.start_object();
+
+    for (std::size_t i = 0; i < value_type_count; i++) {
+        writer.write_key(value_type_to_string(static_cast<JsonValueType>(i)));
+        writer.write_uint64(nodes[i]);
+    }
+
+    writer.end_object();
+
+    writer.write_key("bytes_scanned");
+    writer.write_uint64(bytes_scanned);
+    writer.write_key("strings_allocated");
+    writer.write_uint64(strings_allocated);
+    writer.write_key("string_bytes_allocated");
+    writer.write_uint64(string_bytes_allocated);
+    writer.write_key("max_depth");
+    writer.write_uint64(max_depth);
+
+    writer.write_key("phase_nanoseconds");
+    writer.start_object();
+
+    for (std::size_t i = 0; i < json_phase_count; i++) {
+        writer.write_key(phase_to_string(static_cast<JsonPhase>(i)));
+        writer.write_uint64(phase_nanoseconds[i]);
+    }
+
+    writer.end_object();
+
+    writer.end_object();
+}
+
+JsonTrace::JsonTrace()
+    : m_origin(Clock::now()) {}
+
+auto JsonTrace::add(std::string_view name, Clock::time_point start, Clock::time_point end) -> void {
+    const auto thread = current_thread_id();
+
+    std::lock_guard lock(m_mutex);
+
+    m_events.push_back(Event{name, thread, start, end});
+}
+
+auto JsonTrace::write(JsonWriter& writer) const -> void {
+    const auto microseconds = [](Clock::duration duration) {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    };
+
+    std::lock_guard lock(m_mutex);
+
+    writer.start_object();
+    writer.write_key("traceEvents");
+    writer.start_array();
+
+    for (const auto& event : m_events) {
+        // complete events, one per scope.
+        writer.start_object();
+        writer.write_key("name");
+        writer.write_string(event.name);
+        writer.write_key("cat");
+        writer.write_string("json");
+        writer.write_key("ph");
+        writer.write_string("X");
+        writer.write_key("ts");
+        writer.write_number(microseconds(event.start - m_origin));
+        writer.write_key("dur");
+        writer.write_number(microseconds(event.end - event.start));
+        writer.write_key("pid");
+        writer.write_uint64(1);
+        writer.write_key("tid");
+        writer.write_uint64(event.thread);
+        writer.end_object();
+    }
+
+    writer.end_array();
+    writer.write_key("displayTimeUnit");
+    writer.write_string("ns");
+    writer.end_object();
+}
+
+auto JsonTrace::to_string() const -> std::string {
+    JsonWriter writer;
+
+    write(writer);
+
+    return writer.take();
+}
+
+auto JsonTrace::size() const -> std::size_t {
+    std::lock_guard lock(m_mutex);
+
+    return m_events.size();
+}
+
+JsonStatsScope::JsonStatsScope(ParseStats* stats, JsonTrace* trace)
+    : m_previous_stats(installed_stats), m_previous_trace(installed_trace)
+{
+    installed_stats = stats;
+    installed_trace = trace;
+}
+
+JsonStatsScope::~JsonStatsScope() {
+    installed_stats = m_previous_stats;
+    installed_trace = m_previous_trace;
+}
+
+auto JsonStatsScope::current_stats() -> ParseStats* {
+    return installed_stats;
+}
+
+auto JsonStatsScope::current_trace() -> JsonTrace* {
+    return installed_trace;
+}
+
+JsonPhaseScope::~JsonPhaseScope() {
+    const auto end = JsonTrace::Clock::now();
+
+    if (installed_stats)
+        installed_stats->phase_nanoseconds[static_cast<std::size_t>(m_phase)] += std::chrono::duration_cast<std::chrono::nanoseconds>(end - m_start).count();
+
+    if (installed_trace)
+        installed_trace->add(phase_to_string(m_phase), m_start, end);
+}
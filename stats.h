@@ -0,0 +1,208 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "jsonval.h"
+#include "lexer.h"
+#include "writer.h"
+
+// Opt-in instrumentation of the hot paths. Build with JSON_INSTRUMENTATION
+// defined (the JSON_INSTRUMENTATION cmake option) and install a
+// JsonStatsScope around the work to look at:
+//
+//   ParseStats stats;
+//   JsonTrace trace;
+//   {
+//       JsonStatsScope scope(&stats, &trace);
+//       auto result = JsonParser::parse(input);
+//   }
+//
+// Without JSON_INSTRUMENTATION the hooks below expand to empty statements,
+// nothing is counted and the types here are never touched by the library.
+
+enum class JsonPhase {
+    Index,
+    Validate,
+    Parse,
+    Serialize,
+};
+
+constexpr std::size_t json_phase_count = 4;
+
+constexpr std::size_t token_type_count = static_cast<std::size_t>(TokenType::Garbage) + 1;
+
+constexpr std::size_t value_type_count = static_cast<std::size_t>(JsonValueType::JsonNull) + 1;
+
+auto phase_to_string(JsonPhase phase) -> std::string_view;
+
+struct ParseStats {
+    std::array<std::uint64_t, token_type_count> tokens{};
+    std::array<std::uint64_t, value_type_count> nodes{};
+
+    // input handed to the parsers, not counting what the index skips.
+    std::uint64_t bytes_scanned{0};
+
+    // strings copied out of the input for keys and values, interned ones
+    // are not counted.
+    std::uint64_t strings_allocated{0};
+    std::uint64_t string_bytes_allocated{0};
+
+    std::uint64_t max_depth{0};
+    std::uint64_t depth{0};
+
+    std::array<std::uint64_t, json_phase_count> phase_nanoseconds{};
+
+    auto count_token(TokenType type) -> void {
+        tokens[static_cast<std::size_t>(type)]++;
+    }
+
+    auto count_node(JsonValueType type) -> void {
+        nodes[static_cast<std::size_t>(type)]++;
+    }
+
+    auto count_string(std::size_t length) -> void {
+        strings_allocated++;
+        string_bytes_allocated += length;
+    }
+
+    auto enter() -> void {
+        if (++depth > max_depth)
+            max_depth = depth;
+    }
+
+    auto leave() -> void {
+        depth--;
+    }
+
+    auto reset() -> void;
+
+    // a single object, zero counters included so runs are easy to diff.
+    auto write(JsonWriter& writer) const -> void;
+};
+
+// Scoped events in the Chrome trace event format, load the output of
+// to_string() in chrome://tracing or ui.perfetto.dev. Safe to share
+// between threads.
+class JsonTrace {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    JsonTrace();
+
+    auto add(std::string_view name, Clock::time_point start, Clock::time_point end) -> void;
+
+    auto write(JsonWriter& writer) const -> void;
+
+    auto to_string() const -> std::string;
+
+    auto size() const -> std::size_t;
+
+private:
+    struct Event {
+        std::string_view name;
+        std::uint64_t thread;
+        Clock::time_point start;
+        Clock::time_point end;
+    };
+
+    Clock::time_point m_origin;
+
+    mutable std::mutex m_mutex;
+    std::vector<Event> m_events;
+};
+
+// Installs the collectors for the calling thread until it goes out of
+// scope, the previous ones come back afterwards. Either may be null.
+class JsonStatsScope {
+public:
+    JsonStatsScope(ParseStats* stats, JsonTrace* trace = nullptr);
+
+    JsonStatsScope(const JsonStatsScope& other) = delete;
+
+    auto operator=(const JsonStatsScope& other) -> JsonStatsScope& = delete;
+
+    ~JsonStatsScope();
+
+    static auto current_stats() -> ParseStats*;
+
+    static auto current_trace() -> JsonTrace*;
+
+private:
+    ParseStats* m_previous_stats;
+    JsonTrace* m_previous_trace;
+};
+
+// Times a phase into the installed stats and trace.
+class JsonPhaseScope {
+public:
+    JsonPhaseScope(JsonPhase phase)
+        : m_phase(phase), m_start(JsonTrace::Clock::now()) {}
+
+    JsonPhaseScope(const JsonPhaseScope& other) = delete;
+
+    auto operator=(const JsonPhaseScope& other) -> JsonPhaseScope& = delete;
+
+    ~JsonPhaseScope();
+
+private:
+    JsonPhase m_phase;
+    JsonTrace::Clock::time_point m_start;
+};
+
+// Tracks nesting into the installed stats for as long as it lives.
+class JsonDepthScope {
+public:
+    JsonDepthScope()
+        : m_stats(JsonStatsScope::current_stats())
+    {
+        if (m_stats)
+            m_stats->enter();
+    }
+
+    JsonDepthScope(const JsonDepthScope& other) = delete;
+
+    auto operator=(const JsonDepthScope& other) -> JsonDepthScope& = delete;
+
+    ~JsonDepthScope() {
+        if (m_stats)
+            m_stats->leave();
+    }
+
+private:
+    ParseStats* m_stats;
+};
+
+#define JSON_STATS_CONCAT_(a, b) a##b
+#define JSON_STATS_CONCAT(a, b) JSON_STATS_CONCAT_(a, b)
+
+#ifdef JSON_INSTRUMENTATION
+
+// JSON_STATS(count_token(type)) calls count_token on the installed stats.
+#define JSON_STATS(...)\
+    do {\
+        if (auto* json_stats_ = JsonStatsScope::current_stats())\
+            json_stats_->__VA_ARGS__;\
+    } while (0)
+
+#define JSON_PHASE(phase)\
+    JsonPhaseScope JSON_STATS_CONCAT(json_phase_scope_, __LINE__)(phase)
+
+#define JSON_DEPTH()\
+    JsonDepthScope JSON_STATS_CONCAT(json_depth_scope_, __LINE__)
+
+#else
+
+#define JSON_STATS(...) do {} while (0)
+
+#define JSON_PHASE(phase) do {} while (0)
+
+#define JSON_DEPTH() do {} while (0)
+
+#endif
@@ -0,0 +1,576 @@
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "sax.h"
+#include "tape.h"
+
+namespace {
+
+constexpr auto payload_bits = 56;
+constexpr auto payload_mask = (std::uint64_t{1} << payload_bits) - 1;
+constexpr auto count_shift = 32;
+constexpr auto max_count = (std::uint64_t{1} << (payload_bits - count_shift)) - 1;
+
+auto make_word(TapeTag tag, std::uint64_t payload = 0) -> std::uint64_t {
+    return (static_cast<std::uint64_t>(tag) << payload_bits) | (payload & payload_mask);
+}
+
+}
+
+class JsonTapeBuilder {
+public:
+    auto append(TapeTag tag) -> void {
+        m_tape.m_tape.push_back(make_word(tag));
+    }
+
+    auto append_number(double number) -> void {
+        m_tape.m_tape.push_back(make_word(TapeTag::Number));
+        m_tape.m_tape.push_back(std::bit_cast<std::uint64_t>(number));
+    }
+
+    auto append_int64(std::int64_t number) -> void {
+        m_tape.m_tape.push_back(make_word(TapeTag::Int64));
+        m_tape.m_tape.push_back(static_cast<std::uint64_t>(number));
+    }
+
+    auto append_uint64(std::uint64_t number) -> void {
+        m_tape.m_tape.push_back(make_word(TapeTag::UInt64));
+        m_tape.m_tape.push_back(number);
+    }
+
+    auto append_string(std::string_view string) -> void {
+        const auto length = static_cast<std::uint32_t>(string.length());
+        const auto offset = m_tape.m_strings.length();
+
+        m_tape.m_tape.push_back(make_word(TapeTag::String, offset));
+
+        m_tape.m_strings.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        m_tape.m_strings.append(string);
+    }
+
+    // returns the index of the start word, to be handed to end_container.
+    auto start_container(TapeTag tag) -> std::size_t {
+        m_tape.m_tape.push_back(make_word(tag));
+
+        return m_tape.m_tape.size() - 1;
+    }
+
+    auto end_container(TapeTag tag, std::size_t start, std::uint64_t count) -> void {
+        m_tape.m_tape.push_back(make_word(tag, start));
+
+        const auto end = m_tape.m_tape.size();
+        const auto start_tag = static_cast<TapeTag>(m_tape.m_tape[start] >> payload_bits);
+
+        m_tape.m_tape[start] = make_word(start_tag, (std::min(count, max_count) << count_shift) | end);
+    }
+
+    auto append_value(const JsonValue& value) -> void {
+        switch (value.get_type()) {
+        case JsonValueType::JsonBool:
+            static_cast<const JsonBool&>(value).access([this](const bool& boolean) {
+                    append(boolean ? TapeTag::True : TapeTag::False);
+                    });
+            break;
+        case JsonValueType::JsonNumber:
+            if (const auto* number = std::get_if<std::int64_t>(&static_cast<const JsonNumber&>(value).value()))
+                append_int64(*number);
+            else if (const auto* number = std::get_if<std::uint64_t>(&static_cast<const JsonNumber&>(value).value()))
+                append_uint64(*number);
+            else
+                append_number(std::get<double>(static_cast<const JsonNumber&>(value).value()));
+            break;
+        case JsonValueType::JsonString:
+            static_cast<const JsonString&>(value).access([this](const std::string& string) {
+                    append_string(string);
+                    });
+            break;
+        case JsonValueType::JsonObject:
+            static_cast<const JsonObject&>(value).access([this](const JsonObjectDict& dict) {
+                    const auto start = start_container(TapeTag::StartObject);
+
+                    for (const auto& [key, member] : dict) {
+                        append_string(key.view());
+                        append_value(*member);
+                    }
+
+                    end_container(TapeTag::EndObject, start, dict.size());
+                    });
+            break;
+        case JsonValueType::JsonArray:
+            static_cast<const JsonArray&>(value).access([this](const JsonArrayElements& elements) {
+                    const auto start = start_container(TapeTag::StartArray);
+
+                    for (const auto& elem : elements)
+                        append_value(*elem);
+
+                    end_container(TapeTag::EndArray, start, elements.size());
+                    });
+            break;
+        case JsonValueType::JsonNull:
+            append(TapeTag::Null);
+            break;
+        }
+    }
+
+    auto finish() -> JsonTape {
+        return std::move(m_tape);
+    }
+
+private:
+    JsonTape m_tape;
+};
+
+namespace {
+
+// writes parse events straight to the tape, no intermediate JsonValue is
+// ever created.
+class TapeHandler : public JsonSaxHandler {
+public:
+    auto on_null() -> bool {
+        m_builder.append(TapeTag::Null);
+        return true;
+    }
+
+    auto on_bool(bool boolean) -> bool {
+        m_builder.append(boolean ? TapeTag::True : TapeTag::False);
+        return true;
+    }
+
+    auto on_number(double number) -> bool {
+        m_builder.append_number(number);
+        return true;
+    }
+
+    auto on_int64(std::int64_t number) -> bool {
+        m_builder.append_int64(number);
+        return true;
+    }
+
+    auto on_uint64(std::uint64_t number) -> bool {
+        m_builder.append_uint64(number);
+        return true;
+    }
+
+    auto on_string(std::string_view string) -> bool {
+        m_builder.append_string(string);
+        return true;
+    }
+
+    auto on_key(std::string_view key) -> bool {
+        m_builder.append_string(key);
+        return true;
+    }
+
+    auto on_start_object() -> bool {
+        m_starts.push_back(m_builder.start_container(TapeTag::StartObject));
+        return true;
+    }
+
+    auto on_end_object(std::size_t count) -> bool {
+        m_builder.end_container(TapeTag::EndObject, m_starts.back(), count);
+        m_starts.pop_back();
+        return true;
+    }
+
+    auto on_start_array() -> bool {
+        m_starts.push_back(m_builder.start_container(TapeTag::StartArray));
+        return true;
+    }
+
+    auto on_end_array(std::size_t count) -> bool {
+        m_builder.end_container(TapeTag::EndArray, m_starts.back(), count);
+        m_starts.pop_back();
+        return true;
+    }
+
+    auto finish() -> JsonTape {
+        return m_builder.finish();
+    }
+
+private:
+    JsonTapeBuilder m_builder;
+    std::vector<std::size_t> m_starts;
+};
+
+}
+
+auto JsonTapeRef::ElementIterator::operator*() const -> JsonTapeRef {
+    return JsonTapeRef(m_tape, m_strings, m_index);
+}
+
+auto JsonTapeRef::ElementIterator::operator++() -> ElementIterator& {
+    m_index = (**this).end_index();
+
+    return *this;
+}
+
+auto JsonTapeRef::MemberIterator::operator*() const -> std::pair<std::string_view, JsonTapeRef> {
+    return {
+        JsonTapeRef(m_tape, m_strings, m_index).string_at(m_index),
+        JsonTapeRef(m_tape, m_strings, m_index + 1),
+    };
+}
+
+auto JsonTapeRef::MemberIterator::operator++() -> MemberIterator& {
+    m_index = JsonTapeRef(m_tape, m_strings, m_index + 1).end_index();
+
+    return *this;
+}
+
+auto JsonTapeRef::get_type() const -> JsonValueType {
+    switch (tag()) {
+    case TapeTag::True:
+    case TapeTag::False:
+        return JsonValueType::JsonBool;
+    case TapeTag::Number:
+    case TapeTag::Int64:
+    case TapeTag::UInt64:
+        return JsonValueType::JsonNumber;
+    case TapeTag::String:
+        return JsonValueType::JsonString;
+    case TapeTag::StartObject:
+    case TapeTag::EndObject:
+        return JsonValueType::JsonObject;
+    case TapeTag::StartArray:
+    case TapeTag::EndArray:
+        return JsonValueType::JsonArray;
+    case TapeTag::Null:
+        break;
+    }
+
+    return JsonValueType::JsonNull;
+}
+
+auto JsonTapeRef::as_bool() const -> std::optional<bool> {
+    if (tag() == TapeTag::True)
+        return true;
+
+    if (tag() == TapeTag::False)
+        return false;
+
+    return std::nullopt;
+}
+
+auto JsonTapeRef::as_number() const -> std::optional<double> {
+    switch (tag()) {
+    case TapeTag::Number:
+        return std::bit_cast<double>(m_tape[m_index + 1]);
+    case TapeTag::Int64:
+        return static_cast<double>(static_cast<std::int64_t>(m_tape[m_index + 1]));
+    case TapeTag::UInt64:
+        return static_cast<double>(m_tape[m_index + 1]);
+    default:
+        break;
+    }
+
+    return std::nullopt;
+}
+
+auto JsonTapeRef::as_int64() const -> std::optional<std::int64_t> {
+    if (tag() != TapeTag::Int64)
+        return std::nullopt;
+
+    return static_cast<std::int64_t>(m_tape[m_index + 1]);
+}
+
+auto JsonTapeRef::as_uint64() const -> std::optional<std::uint64_t> {
+    if (tag() == TapeTag::UInt64)
+        return m_tape[m_index + 1];
+
+    if (const auto number = as_int64(); number and *number >= 0)
+        return static_cast<std::uint64_t>(*number);
+
+    return std::nullopt;
+}
+
+auto JsonTapeRef::as_string() const -> std::optional<std::string_view> {
+    if (tag() != TapeTag::String)
+        return std::nullopt;
+
+    return string_at(m_index);
+}
+
+auto JsonTapeRef::size() const -> std::size_t {
+    if (tag() != TapeTag::StartObject and tag() != TapeTag::StartArray)
+        return 0;
+
+    const auto count = payload() >> count_shift;
+
+    if (count < max_count)
+        return count;
+
+    // saturated, count the long way.
+    std::size_t result = 0;
+
+    if (tag() == TapeTag::StartObject) {
+        for ([[maybe_unused]] const auto& member : members())
+            result++;
+    } else {
+        for ([[maybe_unused]] const auto& elem : elements())
+            result++;
+    }
+
+    return result;
+}
+
+auto JsonTapeRef::find(std::string_view key) const -> std::optional<JsonTapeRef> {
+    if (tag() != TapeTag::StartObject)
+        return std::nullopt;
+
+    for (const auto& [member_key, value] : members()) {
+        if (member_key == key)
+            return value;
+    }
+
+    return std::nullopt;
+}
+
+auto JsonTapeRef::at(std::size_t index) const -> std::optional<JsonTapeRef> {
+    if (tag() != TapeTag::StartArray)
+        return std::nullopt;
+
+    for (const auto& elem : elements()) {
+        if (index-- == 0)
+            return elem;
+    }
+
+    return std::nullopt;
+}
+
+auto JsonTapeRef::elements() const -> Range<ElementIterator> {
+    const auto end = tag() == TapeTag::StartArray ? end_index() - 1 : m_index;
+    const auto begin = tag() == TapeTag::StartArray ? m_index + 1 : m_index;
+
+    return Range(ElementIterator(m_tape, m_strings, begin), ElementIterator(m_tape, m_strings, end));
+}
+
+auto JsonTapeRef::members() const -> Range<MemberIterator> {
+    const auto end = tag() == TapeTag::StartObject ? end_index() - 1 : m_index;
+    const auto begin = tag() == TapeTag::StartObject ? m_index + 1 : m_index;
+
+    return Range(MemberIterator(m_tape, m_strings, begin), MemberIterator(m_tape, m_strings, end));
+}
+
+auto JsonTapeRef::to_value() const -> std::shared_ptr<JsonValue> {
+    switch (tag()) {
+    case TapeTag::True:
+        return make_json_value<JsonBool>(true);
+    case TapeTag::False:
+        return make_json_value<JsonBool>(false);
+    case TapeTag::Number:
+        return make_json_value<JsonNumber>(*as_number());
+    case TapeTag::Int64:
+        return make_json_value<JsonNumber>(*as_int64());
+    case TapeTag::UInt64:
+        return make_json_value<JsonNumber>(*as_uint64());
+    case TapeTag::String:
+        return make_json_value<JsonString>(std::string(string_at(m_index)));
+    case TapeTag::StartObject: {
+        auto object = make_json_value<JsonObject>(JsonObject{});
+
+        object->access([this](JsonObjectDict& dict) {
+                dict.reserve(size());
+
+                for (const auto& [key, value] : members())
+                    dict.insert_or_assign(std::string(key), value.to_value());
+                });
+
+        return object;
+    }
+    case TapeTag::StartArray: {
+        auto array = make_json_value<JsonArray>(JsonArray{});
+
+        array->access([this](JsonArrayElements& array_elements) {
+                array_elements.reserve(size());
+
+                for (const auto& elem : elements())
+                    array_elements.push_back(elem.to_value());
+                });
+
+        return array;
+    }
+    default:
+        break;
+    }
+
+    return make_json_value<JsonNull>();
+}
+
+auto JsonTapeRef::tag() const -> TapeTag {
+    return static_cast<TapeTag>(m_tape[m_index] >> payload_bits);
+}
+
+auto JsonTapeRef::payload() const -> std::uint64_t {
+    return m_tape[m_index] & payload_mask;
+}
+
+auto JsonTapeRef::string_at(std::size_t index) const -> std::string_view {
+    const auto offset = m_tape[index] & payload_mask;
+
+    std::uint32_t length;
+    std::memcpy(&length, m_strings + offset, sizeof(length));
+
+    return std::string_view(m_strings + offset + sizeof(length), length);
+}
+
+auto JsonTapeRef::end_index() const -> std::size_t {
+    switch (tag()) {
+    case TapeTag::Number:
+    case TapeTag::Int64:
+    case TapeTag::UInt64:
+        return m_index + 2;
+    case TapeTag::StartObject:
+    case TapeTag::StartArray:
+        return payload() & ((std::uint64_t{1} << count_shift) - 1);
+    default:
+        break;
+    }
+
+    return m_index + 1;
+}
+
+auto is_well_formed_tape(std::span<const std::uint64_t> words, std::string_view strings) -> bool {
+    struct Open {
+        std::size_t start;
+        bool is_object;
+        std::uint64_t count;
+    };
+
+    // one entry per open container, nesting is not recursion here.
+    std::vector<Open> open;
+
+    const auto is_string_at = [&](std::size_t index) {
+        if (words[index] >> payload_bits != static_cast<std::uint64_t>(TapeTag::String))
+            return false;
+
+        const auto offset = words[index] & payload_mask;
+
+        if (offset > strings.length() or strings.length() - offset < sizeof(std::uint32_t))
+            return false;
+
+        std::uint32_t length;
+        std::memcpy(&length, strings.data() + offset, sizeof(length));
+
+        return length <= strings.length() - offset - sizeof(length);
+    };
+
+    const auto tag_at = [&words](std::size_t index) {
+        return static_cast<TapeTag>(words[index] >> payload_bits);
+    };
+
+    const auto is_end = [](TapeTag tag) {
+        return tag == TapeTag::EndObject or tag == TapeTag::EndArray;
+    };
+
+    std::size_t index = 0;
+
+    while (index < words.size()) {
+        auto tag = tag_at(index);
+
+        // a member starts with its key, the closing word has to come where
+        // the next key would.
+        if (not open.empty() and open.back().is_object and not is_end(tag)) {
+            if (not is_string_at(index) or ++index == words.size())
+                return false;
+
+            tag = tag_at(index);
+
+            if (is_end(tag))
+                return false;
+        }
+
+        switch (tag) {
+        case TapeTag::Null:
+        case TapeTag::True:
+        case TapeTag::False:
+            index++;
+            break;
+        case TapeTag::Number:
+        case TapeTag::Int64:
+        case TapeTag::UInt64:
+            if (words.size() - index < 2)
+                return false;
+
+            index += 2;
+            break;
+        case TapeTag::String:
+            if (not is_string_at(index))
+                return false;
+
+            index++;
+            break;
+        case TapeTag::StartObject:
+        case TapeTag::StartArray:
+            if (not open.empty())
+                open.back().count++;
+
+            open.push_back(Open{index, tag == TapeTag::StartObject, 0});
+            index++;
+            continue;
+        case TapeTag::EndObject:
+        case TapeTag::EndArray: {
+            if (open.empty() or open.back().is_object != (tag == TapeTag::EndObject))
+                return false;
+
+            const auto [start, is_object, count] = open.back();
+            const auto start_payload = words[start] & payload_mask;
+
+            if ((words[index] & payload_mask) != start
+                    or (start_payload & ((std::uint64_t{1} << count_shift) - 1)) != index + 1
+                    or start_payload >> count_shift != std::min(count, max_count))
+                return false;
+
+            open.pop_back();
+            index++;
+
+            if (open.empty())
+                return index == words.size();
+
+            continue;
+        }
+        default:
+            return false;
+        }
+
+        // a scalar, the whole tape unless it is inside a container.
+        if (open.empty())
+            return index == words.size();
+
+        open.back().count++;
+    }
+
+    return false;
+}
+
+auto JsonTape::parse(std::string_view input) -> ErrorOr<JsonTape> {
+    TapeHandler handler;
+
+    TRY(JsonSaxParser<TapeHandler>::parse(input, handler));
+
+    return handler.finish();
+}
+
+auto JsonTape::from_value(const JsonValue& value) -> JsonTape {
+    JsonTapeBuilder builder;
+
+    builder.append_value(value);
+
+    return builder.finish();
+}
+
+auto JsonTape::root() const -> JsonTapeRef {
+    return JsonTapeRef(m_tape.data(), m_strings.data(), 0);
+}
+
+auto JsonTape::to_value() const -> std::shared_ptr<JsonValue> {
+    return root().to_value();
+}
+
+auto JsonTape::tape() const -> const std::vector<std::uint64_t>& {
+    return m_tape;
+}
+
+auto JsonTape::strings() const -> const std::string& {
+    return m_strings;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "jsonval.h"
+#include "parser.h"
+
+// A document stored as one flat array of tagged 64-bit words. The tag lives
+// in the top byte, the payload in the remaining 56 bits:
+//
+//   null, true, false   no payload
+//   number              followed by one word holding the raw double, int64
+//                       or uint64, depending on the tag
+//   string              offset into the string buffer, which holds a 32-bit
+//                       length followed by the bytes
+//   start of container  index one past the matching end (low 32 bits) and
+//                       the number of children (upper 24 bits, saturated)
+//   end of container    index of the matching start
+//
+// Object members are a string word for the key followed by the value.
+enum class TapeTag : std::uint8_t {
+    Null = 'n',
+    True = 't',
+    False = 'f',
+    Number = 'd',
+    Int64 = 'l',
+    UInt64 = 'u',
+    String = '"',
+    StartObject = '{',
+    EndObject = '}',
+    StartArray = '[',
+    EndArray = ']',
+};
+
+class JsonTapeRef {
+public:
+    class ElementIterator {
+    public:
+        ElementIterator(const std::uint64_t* tape, const char* strings, std::size_t index)
+            : m_tape(tape), m_strings(strings), m_index(index) {}
+
+        auto operator*() const -> JsonTapeRef;
+
+        auto operator++() -> ElementIterator&;
+
+        auto operator==(const ElementIterator& other) const -> bool {
+            return m_index == other.m_index;
+        }
+
+    private:
+        const std::uint64_t* m_tape;
+        const char* m_strings;
+        std::size_t m_index;
+    };
+
+    class MemberIterator {
+    public:
+        MemberIterator(const std::uint64_t* tape, const char* strings, std::size_t index)
+            : m_tape(tape), m_strings(strings), m_index(index) {}
+
+        auto operator*() const -> std::pair<std::string_view, JsonTapeRef>;
+
+        auto operator++() -> MemberIterator&;
+
+        auto operator==(const MemberIterator& other) const -> bool {
+            return m_index == other.m_index;
+        }
+
+    private:
+        const std::uint64_t* m_tape;
+        const char* m_strings;
+        std::size_t m_index;
+    };
+
+    template <typename Iterator>
+    class Range {
+    public:
+        Range(Iterator begin, Iterator end)
+            : m_begin(begin), m_end(end) {}
+
+        auto begin() const -> Iterator { return m_begin; }
+
+        auto end() const -> Iterator { return m_end; }
+
+    private:
+        Iterator m_begin;
+        Iterator m_end;
+    };
+
+    JsonTapeRef(const std::uint64_t* tape, const char* strings, std::size_t index)
+        : m_tape(tape), m_strings(strings), m_index(index) {}
+
+    auto get_type() const -> JsonValueType;
+
+    auto as_bool() const -> std::optional<bool>;
+
+    // any number, integers beyond 2^53 are rounded.
+    auto as_number() const -> std::optional<double>;
+
+    auto as_int64() const -> std::optional<std::int64_t>;
+
+    auto as_uint64() const -> std::optional<std::uint64_t>;
+
+    auto as_string() const -> std::optional<std::string_view>;
+
+    // number of elements or members, zero for scalars.
+    auto size() const -> std::size_t;
+
+    // linear lookup of an object member.
+    auto find(std::string_view key) const -> std::optional<JsonTapeRef>;
+
+    auto at(std::size_t index) const -> std::optional<JsonTapeRef>;
+
+    // only meaningful on arrays.
+    auto elements() const -> Range<ElementIterator>;
+
+    // only meaningful on objects.
+    auto members() const -> Range<MemberIterator>;
+
+    auto to_value() const -> std::shared_ptr<JsonValue>;
+
+private:
+    auto tag() const -> TapeTag;
+
+    auto payload() const -> std::uint64_t;
+
+    auto string_at(std::size_t index) const -> std::string_view;
+
+    // index of the word after this value.
+    auto end_index() const -> std::size_t;
+
+private:
+    const std::uint64_t* m_tape;
+    const char* m_strings;
+    std::size_t m_index;
+};
+
+class JsonTape {
+public:
+    JsonTape() = default;
+
+    JsonTape(const JsonTape& other) = delete;
+
+    JsonTape(JsonTape&& other) = default;
+
+    auto operator=(JsonTape&& other) -> JsonTape& = default;
+
+    static auto parse(std::string_view input) -> ErrorOr<JsonTape>;
+
+    static auto from_value(const JsonValue& value) -> JsonTape;
+
+    auto root() const -> JsonTapeRef;
+
+    auto to_value() const -> std::shared_ptr<JsonValue>;
+
+    auto tape() const -> const std::vector<std::uint64_t>&;
+
+    auto strings() const -> const std::string&;
+
+private:
+    friend class JsonTapeBuilder;
+
+    std::vector<std::uint64_t> m_tape;
+    std::string m_strings;
+};
+
+// True if words and strings hold exactly one well formed value: known tags,
+// numbers with their second word, strings inside the string section, keys
+// that are strings and containers closed by their matching end. A tape that
+// passes can be walked by JsonTapeRef without reading out of bounds, one
+// that comes from outside has to pass before it is walked.
+auto is_well_formed_tape(std::span<const std::uint64_t> words, std::string_view strings) -> bool;
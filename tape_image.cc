@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hash.h"
+#include "tape_image.h"
+
+namespace {
+
+constexpr char magic[8] = {'J', 'S', 'O', 'N', 'T', 'A', 'P', 'E'};
+constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+struct ImageHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t tape_words;
+    std::uint64_t string_bytes;
+    std::uint64_t checksum;
+    std::uint64_t reserved;
+};
+
+static_assert(sizeof(ImageHeader) == 48);
+
+auto invalid_image(std::string_view reason) -> JsonError {
+    return JsonError(JsonErrorCode::InvalidImage, 0, reason);
+}
+
+auto write_all(int fd, std::string_view data) -> bool {
+    while (not data.empty()) {
+        const auto count = ::write(fd, data.data(), data.length());
+
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+
+            return false;
+        }
+
+        data.remove_prefix(static_cast<std::size_t>(count));
+    }
+
+    return true;
+}
+
+}
+
+auto JsonTapeImage::serialize(const JsonTape& tape) -> std::string {
+    const auto& words = tape.tape();
+    const auto& strings = tape.strings();
+
+    const auto tape_bytes = words.size() * sizeof(std::uint64_t);
+
+    std::string result(sizeof(ImageHeader) + tape_bytes + strings.length(), '\0');
+
+    auto* body = result.data() + sizeof(ImageHeader);
+
+    std::memcpy(body, words.data(), tape_bytes);
+    std::memcpy(body + tape_bytes, strings.data(), strings.length());
+
+    ImageHeader header{};
+
+    std::memcpy(header.magic, magic, sizeof(magic));
+    header.version = version;
+    header.byte_order = byte_order_mark;
+    header.tape_words = words.size();
+    header.string_bytes = strings.length();
+    header.checksum = hash_bytes(std::string_view(body, tape_bytes + strings.length()));
+
+    std::memcpy(result.data(), &header, sizeof(header));
+
+    return result;
+}
+
+auto JsonTapeImage::save(const JsonTape& tape, const std::string& path) -> ErrorOr<std::monostate> {
+    const auto image = serialize(tape);
+
+    auto temporary = path + ".XXXXXX";
+
+    const auto fd = ::mkostemp(temporary.data(), O_CLOEXEC);
+
+    if (fd < 0)
+        return JsonError::file_error(temporary, "cannot create", errno);
+
+    // mkostemp creates the file private to its owner.
+    const auto written = ::fchmod(fd, 0644) == 0 and write_all(fd, image) and ::fsync(fd) == 0;
+
+    if (not written) {
+        auto error = JsonError::file_error(temporary, "cannot write", errno);
+
+        ::close(fd);
+        ::unlink(temporary.c_str());
+
+        return error;
+    }
+
+    if (::close(fd) != 0 or std::rename(temporary.c_str(), path.c_str()) != 0) {
+        auto error = JsonError::file_error(path, "cannot save", errno);
+
+        ::unlink(temporary.c_str());
+
+        return error;
+    }
+
+    // the rename itself only survives a crash once the directory is synced.
+    const auto slash = path.rfind('/');
+    const auto directory = slash == std::string::npos ? std::string(".") : path.substr(0, std::max<std::size_t>(slash, 1));
+
+    const auto directory_fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (directory_fd < 0)
+        return JsonError::file_error(directory, "cannot sync", errno);
+
+    const auto synced = ::fsync(directory_fd) == 0;
+    const auto sync_errno = errno;
+
+    ::close(directory_fd);
+
+    if (not synced)
+        return JsonError::file_error(directory, "cannot sync", sync_errno);
+
+    return std::monostate{};
+}
+
+auto JsonTapeImage::open(const std::string& path, const JsonTapeImageOptions& options) -> ErrorOr<JsonTapeImage> {
+    auto file = TRY(MappedFile::open(path));
+    const auto contents = file.contents();
+
+    if (contents.length() < sizeof(ImageHeader))
+        return invalid_image("truncated header");
+
+    ImageHeader header;
+    std::memcpy(&header, contents.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, magic, sizeof(magic)) != 0)
+        return invalid_image("not a tape image");
+
+    if (header.version != version)
+        return invalid_image("unsupported version");
+
+    if (header.byte_order != byte_order_mark)
+        return invalid_image("foreign byte order");
+
+    const auto body = contents.substr(sizeof(ImageHeader));
+
+    // an empty tape has no root to hand out.
+    if (header.tape_words == 0
+            or header.tape_words > body.length() / sizeof(std::uint64_t)
+            or header.string_bytes != body.length() - header.tape_words * sizeof(std::uint64_t))
+        return invalid_image("size mismatch");
+
+    // mappings are page aligned and the read fallback comes from the heap,
+    // the words are read in place.
+    if (reinterpret_cast<std::uintptr_t>(body.data()) % alignof(std::uint64_t) != 0)
+        return invalid_image("misaligned");
+
+    if (options.verify_checksum and hash_bytes(body) != header.checksum)
+        return invalid_image("checksum mismatch");
+
+    const auto words = std::span(reinterpret_cast<const std::uint64_t*>(body.data()), header.tape_words);
+
+    if (not is_well_formed_tape(words, body.substr(header.tape_words * sizeof(std::uint64_t))))
+        return invalid_image("malformed tape");
+
+    return JsonTapeImage(std::move(file), header.tape_words);
+}
+
+auto JsonTapeImage::root() const -> JsonTapeRef {
+    const auto* body = m_file.contents().data() + sizeof(ImageHeader);
+
+    return JsonTapeRef(reinterpret_cast<const std::uint64_t*>(body), body + m_tape_words * sizeof(std::uint64_t), 0);
+}
+
+auto JsonTapeImage::is_mapped() const -> bool {
+    return m_file.is_mapped();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <variant>
+
+#include "mapped_file.h"
+#include "tape.h"
+
+struct JsonTapeImageOptions {
+    // hashes the whole image on open. costs one pass at memory speed, turn
+    // it off for images this process wrote itself.
+    bool verify_checksum{true};
+};
+
+// A JsonTape saved to disk as is, so a later process can map it and walk it
+// right away: no lexing, no parsing and no allocation per node. The tape only
+// holds indices and offsets, never pointers, so the bytes are valid wherever
+// they end up in memory.
+//
+//   offset  size
+//        0     8  magic "JSONTAPE"
+//        8     4  format version
+//       12     4  0x01020304 in the byte order of the writer
+//       16     8  number of tape words
+//       24     8  size of the string section
+//       32     8  checksum of everything after the header
+//       40     8  reserved, zero
+//       48        the tape words, then the string section
+//
+// Images are checked for their magic, version, byte order, size and
+// checksum, and the tape is walked once on open, so a damaged image is
+// rejected rather than read out of bounds even without the checksum.
+class JsonTapeImage {
+public:
+    static constexpr std::uint32_t version = 1;
+
+    JsonTapeImage(const JsonTapeImage& other) = delete;
+
+    JsonTapeImage(JsonTapeImage&& other) = default;
+
+    auto operator=(JsonTapeImage&& other) -> JsonTapeImage& = default;
+
+    // the image bytes, header included.
+    static auto serialize(const JsonTape& tape) -> std::string;
+
+    // written to a uniquely named file next to path, synced and renamed
+    // into place, so a process opening path never sees half an image, not
+    // even after a crash, and concurrent saves do not trample each other.
+    // the last rename wins.
+    static auto save(const JsonTape& tape, const std::string& path) -> ErrorOr<std::monostate>;
+
+    static auto open(const std::string& path, const JsonTapeImageOptions& options = {}) -> ErrorOr<JsonTapeImage>;
+
+    // valid for as long as the image is.
+    auto root() const -> JsonTapeRef;
+
+    auto is_mapped() const -> bool;
+
+private:
+    JsonTapeImage(MappedFile file, std::size_t tape_words)
+        : m_file(std::move(file)), m_tape_words(tape_words) {}
+
+private:
+    MappedFile m_file;
+    std::size_t m_tape_words;
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <atomic>
+#include <cstdio>
+#include <variant>
+
+#include "error.h"
+
+// Just enough to write the test programs with: a failed CHECK reports
+// itself and the program carries on, check_result() is what main returns.
+// Safe to use from any thread.
+inline std::atomic<int> check_failures{0};
+
+#define CHECK(condition)\
+    do {\
+        if (not (condition)) {\
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);\
+            check_failures++;\
+        }\
+    } while (0)
+
+template<typename T>
+auto is_error(const ErrorOr<T>& result) -> bool {
+    return std::holds_alternative<JsonError>(result);
+}
+
+inline auto check_result() -> int {
+    if (check_failures != 0)
+        std::fprintf(stderr, "%d checks failed\n", check_failures.load());
+
+    return check_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "bind.h"
+#include "check.h"
+#include "validate.h"
+
+namespace {
+
+struct Point {
+    std::int32_t x;
+    std::optional<std::uint8_t> small;
+};
+
+}
+
+template <>
+struct JsonBinding<Point> {
+    static constexpr auto fields = std::make_tuple(
+            json_field("x", &Point::x),
+            json_field("small", &Point::small));
+};
+
+namespace {
+
+constexpr auto lenient = JsonBindOptions{.allow_unknown_fields = true};
+
+auto error_code(std::string_view input, const JsonBindOptions& options = {}) -> std::optional<JsonErrorCode> {
+    const auto result = JsonBinder<Point>::parse(input, options);
+
+    if (not is_error(result))
+        return std::nullopt;
+
+    return std::get<JsonError>(result).code();
+}
+
+auto test_skipped_members() -> void {
+    // whatever is skipped, it has to be json the validator takes.
+    const std::string unknowns[] = {
+        "1", R"("s")", "null", "[]", "{}", R"([1,[2,{"a":[]}],{"b":{"c":null}}])", R"({"k":[true,false]})",
+        "[1,,]", "[1,,}]", "[1 2]", R"({"a" 1})", R"({"a":})", R"({1:2})", "[1,]", R"({"a":1,})", "[}", "{]", "[",
+        "]", ":", "tru", R"({"a":[1]]})",
+    };
+
+    for (const auto& unknown : unknowns) {
+        const auto input = R"({"unknown":)" + unknown + R"(,"x":1})";
+        const auto valid = not is_error(JsonValidator::validate(input));
+
+        CHECK(valid == not error_code(input, lenient).has_value());
+        CHECK(error_code(input) == JsonErrorCode::UnknownField);
+    }
+
+    CHECK(error_code(R"({"unknown":[1,,}],"x":1})", lenient).has_value());
+
+    const auto deep = R"({"x":1,"unknown":)" + std::string(100000, '[') + std::string(100000, ']') + "}";
+
+    CHECK(not error_code(deep, lenient));
+}
+
+auto test_integers() -> void {
+    CHECK(not error_code(R"({"x":-2147483648,"small":255})"));
+    CHECK(std::get<Point>(JsonBinder<Point>::parse(R"({"x":-0})")).x == 0);
+
+    CHECK(error_code(R"({"x":1.5})") == JsonErrorCode::NotAnInteger);
+    CHECK(error_code(R"({"x":1e2})") == JsonErrorCode::NotAnInteger);
+    CHECK(error_code(R"({"x":2147483648})") == JsonErrorCode::IntegerOutOfRange);
+    CHECK(error_code(R"({"x":1,"small":256})") == JsonErrorCode::IntegerOutOfRange);
+    CHECK(error_code(R"({"x":1,"small":-1})") == JsonErrorCode::IntegerOutOfRange);
+    CHECK(error_code(R"({"x":18446744073709551616})") == JsonErrorCode::IntegerOutOfRange);
+
+    const auto message = std::get<JsonError>(JsonBinder<Point>::parse(R"({"x":1.5})")).message();
+
+    CHECK(message.find("not an integer: 1.5") != std::string::npos);
+}
+
+}
+
+auto main() -> int {
+    test_skipped_members();
+    test_integers();
+
+    return check_result();
+}
@@ -0,0 +1,121 @@
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+
+#include "cbor.h"
+#include "check.h"
+#include "parser.h"
+
+namespace {
+
+auto parse(std::string_view input) -> JsonObject {
+    return std::get<JsonObject>(JsonParser::parse(input));
+}
+
+auto round_trip(const JsonValue& value) -> std::string {
+    const auto decoded = JsonCbor::decode(JsonCbor::encode(value));
+
+    if (is_error(decoded))
+        return "error";
+
+    return std::get<1>(decoded)->serialize();
+}
+
+auto decode_number(const JsonNumber& number) -> NumberValue {
+    const auto decoded = std::get<1>(JsonCbor::decode(JsonCbor::encode(number)));
+
+    return static_cast<const JsonNumber&>(*decoded).value();
+}
+
+auto test_documents() -> void {
+    const char* documents[] = {
+        "{}",
+        R"({"a":null,"b":true,"c":false,"s":"","t":"café 😀","u":"x\"y\\z"})",
+        R"({"n":[0,-1,23,24,255,256,65535,65536,4294967295,4294967296,-24,-25,-4294967297]})",
+        R"({"d":[0.5,-0.0,1e-9,3.141592653589793,1.5e300,-2.5]})",
+        R"({"i":[9223372036854775807,-9223372036854775808,18446744073709551615]})",
+        R"({"nested":{"a":[[],{},[{"b":[1,[2,[3]]]}]],"":{"":""}}})",
+    };
+
+    for (const auto* document : documents) {
+        const auto object = parse(document);
+
+        CHECK(round_trip(object) == object.serialize());
+    }
+
+    // one buffer for several messages.
+    std::string out;
+
+    JsonCbor::encode(parse(R"({"a":1})"), out);
+    JsonCbor::encode(parse(R"({"b":2})"), out);
+
+    CHECK(out.length() == 2 * JsonCbor::encode(parse(R"({"a":1})")).length());
+}
+
+auto test_numbers_keep_their_representation() -> void {
+    CHECK(std::get<std::int64_t>(decode_number(JsonNumber(std::int64_t{-5}))) == -5);
+    CHECK(std::get<std::int64_t>(decode_number(JsonNumber(std::numeric_limits<std::int64_t>::min()))) == std::numeric_limits<std::int64_t>::min());
+    CHECK(std::get<std::uint64_t>(decode_number(JsonNumber(std::numeric_limits<std::uint64_t>::max()))) == std::numeric_limits<std::uint64_t>::max());
+
+    std::mt19937_64 random(22);
+
+    for (int i = 0; i < 2000; i++) {
+        const auto number = std::bit_cast<double>(random());
+
+        if (not std::isfinite(number))
+            continue;
+
+        CHECK(std::bit_cast<std::uint64_t>(std::get<double>(decode_number(JsonNumber(number)))) == std::bit_cast<std::uint64_t>(number));
+    }
+
+    // exact in float32, so it takes five bytes instead of nine.
+    CHECK(JsonCbor::encode(JsonNumber(0.5)).length() == 5);
+    CHECK(JsonCbor::encode(JsonNumber(0.1)).length() == 9);
+    CHECK(std::signbit(std::get<double>(decode_number(JsonNumber(-0.0)))));
+}
+
+auto test_malformed() -> void {
+    const auto encoded = JsonCbor::encode(parse(R"({"a":[1,"two",{"three":3.5}],"b":"text"})"));
+
+    // every prefix is missing something.
+    for (std::size_t length = 0; length < encoded.length(); length++)
+        CHECK(is_error(JsonCbor::decode(encoded.substr(0, length))));
+
+    // more than one item.
+    CHECK(is_error(JsonCbor::decode(encoded + encoded)));
+
+    const std::string rejected[] = {
+        std::string("\x41\x00", 2),   // byte string
+        "\xc0\x60",                   // tag
+        "\x9f\xff",                   // indefinite array
+        "\xf7",                       // undefined
+        "\xa1\x01\x01",               // integer key
+        "\x7a\xff\xff\xff\xff",       // string longer than the input
+        "\x9b\xff\xff\xff\xff\xff\xff\xff\xff", // array longer than the input
+    };
+
+    for (const auto& input : rejected)
+        CHECK(is_error(JsonCbor::decode(input)));
+
+    const auto depth_limit = JsonCborOptions{.max_depth = 10};
+
+    CHECK(is_error(JsonCbor::decode(std::string(11, '\x81') + "\x01", depth_limit)));
+    CHECK(not is_error(JsonCbor::decode(std::string(10, '\x81') + "\x01", depth_limit)));
+
+    // float16 is read even though it is never written.
+    const auto half = JsonCbor::decode(std::string("\xf9\x3c\x00", 3));
+
+    CHECK(not is_error(half) and std::get<1>(half)->serialize() == "1");
+}
+
+}
+
+auto main() -> int {
+    test_documents();
+    test_numbers_keep_their_representation();
+    test_malformed();
+
+    return check_result();
+}
@@ -0,0 +1,172 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "document.h"
+#include "parser.h"
+
+namespace {
+
+auto parse_document(std::string_view input) -> JsonDocument {
+    return JsonDocument(std::get<JsonObject>(JsonParser::parse(input)));
+}
+
+auto value_at(const JsonDocument& document, std::string_view pointer) -> std::string {
+    const auto found = document.find(pointer);
+
+    if (is_error(found))
+        return "error";
+
+    const auto& ref = std::get<1>(found);
+
+    return ref ? ref->serialize() : "missing";
+}
+
+auto counter_of(const JsonDocument& document) -> std::int64_t {
+    const auto found = std::get<1>(document.find("/counter"));
+
+    return found ? found->as_int64().value_or(-1) : 0;
+}
+
+auto test_persistent_updates() -> void {
+    const auto original = parse_document(R"({"a":{"b":[1,2,{"c":3}]},"big":{"x":[1,2,3]},"s":"t"})");
+
+    const auto replaced = std::get<1>(original.set("/a/b/2/c", JsonNumber(42)));
+    const auto appended = std::get<1>(replaced.set("/a/b/-", JsonString("end")));
+    const auto added = std::get<1>(appended.set("/a/new", JsonNull()));
+
+    CHECK(original.serialize() == R"({"a":{"b":[1,2,{"c":3}]},"big":{"x":[1,2,3]},"s":"t"})");
+    CHECK(replaced.serialize() == R"({"a":{"b":[1,2,{"c":42}]},"big":{"x":[1,2,3]},"s":"t"})");
+    CHECK(added.serialize() == R"({"a":{"b":[1,2,{"c":42},"end"],"new":null},"big":{"x":[1,2,3]},"s":"t"})");
+
+    // only the path to the change is copied.
+    const auto big = std::get<1>(original.find("/big"));
+    const auto a = std::get<1>(original.find("/a"));
+
+    CHECK(big and std::get<1>(added.find("/big"))->is_same(*big));
+    CHECK(a and not std::get<1>(added.find("/a"))->is_same(*a));
+
+    const auto nested = std::get<1>(added.set("/big/x/0", original));
+
+    CHECK(value_at(nested, "/big/x/0/s") == R"("t")");
+    CHECK(std::get<1>(nested.find("/big/x/0"))->is_same(original.root()));
+
+    CHECK(std::get<1>(original.set("", JsonBool(true))).serialize() == "true");
+}
+
+auto test_lookups() -> void {
+    const auto document = parse_document(R"({"a":[10,{"b~c":"x","d/e":null}],"n":-5})");
+
+    CHECK(value_at(document, "") == document.serialize());
+    CHECK(value_at(document, "/a/0") == "10");
+    CHECK(value_at(document, "/a/1/b~0c") == R"("x")");
+    CHECK(value_at(document, "/a/1/d~1e") == "null");
+    CHECK(value_at(document, "/a/2") == "missing");
+    CHECK(value_at(document, "/nope") == "missing");
+
+    // malformed pointers are errors, not missing values.
+    CHECK(value_at(document, "a") == "error");
+    CHECK(value_at(document, "/a~2") == "error");
+
+    const auto root = document.root();
+
+    CHECK(root.size() == 2);
+    CHECK(root.find("n")->as_int64() == -5);
+    CHECK(root.find("a")->at(0)->as_number() == 10.0);
+    CHECK(not root.find("a")->at(0)->as_string());
+
+    std::string keys;
+
+    for (const auto& [key, value] : root.members())
+        keys += std::string(key) + ":" + value_type_to_string(value.get_type()).data() + " ";
+
+    CHECK(keys == "a:array n:number ");
+
+    std::size_t elements = 0;
+
+    for (const auto element : root.find("a")->elements())
+        elements += element.get_type() == JsonValueType::JsonNumber ? 1 : 10;
+
+    CHECK(elements == 11);
+}
+
+auto test_set_errors() -> void {
+    const auto document = parse_document(R"({"a":{"b":[1,2]},"s":"t"})");
+
+    for (const auto* pointer : {"/nope/x", "/s/x", "/a/b/9", "/a/b/x", "/a/b/-/x", "bad"})
+        CHECK(is_error(document.set(pointer, JsonNull())));
+}
+
+// writers bump a counter through update while readers check they never see
+// it go backwards. meant to be run under -DJSON_SANITIZE=thread as well.
+auto test_concurrent_versions() -> void {
+    constexpr int writer_count = 2;
+    constexpr int updates_per_writer = 300;
+
+    JsonDocumentRoot root(parse_document(R"({"counter":0,"payload":{"x":[1,2,3]}})"));
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> went_back{0};
+    std::atomic<int> lost_payload{0};
+
+    std::vector<std::thread> readers;
+
+    for (int i = 0; i < 3; i++) {
+        readers.emplace_back([&] {
+                JsonDocumentReader reader(root);
+                std::int64_t last = 0;
+
+                while (not stop.load()) {
+                    const auto& document = reader.get();
+                    const auto counter = counter_of(document);
+
+                    if (counter < last)
+                        went_back++;
+
+                    if (value_at(document, "/payload/x/2") != "3")
+                        lost_payload++;
+
+                    last = counter;
+                }
+                });
+    }
+
+    std::vector<std::thread> writers;
+
+    for (int i = 0; i < writer_count; i++) {
+        writers.emplace_back([&] {
+                for (int j = 0; j < updates_per_writer; j++) {
+                    const auto result = root.update([](const JsonDocument& current) {
+                            return current.set("/counter", JsonNumber(counter_of(current) + 1));
+                            });
+
+                    CHECK(not is_error(result));
+                }
+                });
+    }
+
+    for (auto& writer : writers)
+        writer.join();
+
+    stop = true;
+
+    for (auto& reader : readers)
+        reader.join();
+
+    CHECK(went_back == 0);
+    CHECK(lost_payload == 0);
+    CHECK(counter_of(root.load()) == writer_count * updates_per_writer);
+    CHECK(root.version() == writer_count * updates_per_writer);
+}
+
+}
+
+auto main() -> int {
+    test_persistent_updates();
+    test_lookups();
+    test_set_errors();
+    test_concurrent_versions();
+
+    return check_result();
+}
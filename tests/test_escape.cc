@@ -0,0 +1,211 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "escape.h"
+#include "parser.h"
+#include "validate.h"
+#include "writer.h"
+
+namespace {
+
+constexpr SimdLevel levels[] = {SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2};
+
+// pieces random strings are made of, every kind of byte the scanners tell
+// apart, well formed or not.
+const std::vector<std::string> fragments = {
+    "a", "plain text ", "\"", "\\", "\\n", "\\u00e9", "\\ud83d\\ude00", "\\ud83d", "\\ude00", "\\x",
+    "\x01", "\x1f", "\x7f",
+    "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80",
+    "\xc3", "\xe2\x82", "\xf0\x9f\x98",
+    "\xc0\x80", "\xe0\x80\x80", "\xf0\x80\x80\x80",
+    "\xed\xa0\x80", "\xf4\x90\x80\x80", "\x80", "\xff",
+};
+
+// the fragments that are valid utf-8 on their own.
+auto utf8_fragments() -> std::vector<std::string> {
+    std::vector<std::string> result;
+
+    for (const auto& fragment : fragments) {
+        if (validate_utf8(fragment, SimdLevel::Scalar))
+            result.push_back(fragment);
+    }
+
+    return result;
+}
+
+auto random_string(std::mt19937& random, const std::vector<std::string>& from, std::size_t pieces) -> std::string {
+    std::uniform_int_distribution<std::size_t> pick(0, from.size() - 1);
+
+    std::string result;
+
+    for (std::size_t i = 0; i < pieces; i++)
+        result += from[pick(random)];
+
+    return result;
+}
+
+auto same_scan(const StringScan& lhs, const StringScan& rhs) -> bool {
+    return lhs.length == rhs.length
+        and lhs.has_escapes == rhs.has_escapes
+        and lhs.has_invalid_escape == rhs.has_invalid_escape
+        and lhs.has_non_ascii == rhs.has_non_ascii
+        and lhs.has_control == rhs.has_control;
+}
+
+auto test_levels_match_scalar() -> void {
+    std::mt19937 random(20);
+
+    const auto valid = utf8_fragments();
+
+    // every other string is valid utf-8, so the validators get past the
+    // first few bytes.
+    for (std::size_t round = 0; round < 4000; round++) {
+        const auto text = random_string(random, round % 2 == 0 ? fragments : valid, round % 40);
+
+        for (const auto level : levels) {
+            CHECK(same_scan(scan_string_literal(text, level), scan_string_literal(text, SimdLevel::Scalar)));
+            CHECK(validate_utf8(text, level) == validate_utf8(text, SimdLevel::Scalar));
+            CHECK(find_escape(text, false, level) == find_escape(text, false, SimdLevel::Scalar));
+            CHECK(find_escape(text, true, level) == find_escape(text, true, SimdLevel::Scalar));
+        }
+    }
+}
+
+auto test_surrogates() -> void {
+    std::string out;
+
+    CHECK(check_escapes(R"(\ud83d\ude00)"));
+    unescape_string(R"(\ud83d\ude00)", out);
+    CHECK(out == "\xf0\x9f\x98\x80");
+
+    CHECK(escape_length(R"(\ud83d\ude00)") == 12);
+    CHECK(escape_length(R"(\u00e9)") == 6);
+    CHECK(escape_length(R"(\n)") == 2);
+
+    // a high half alone, followed by something else, or a low half first.
+    for (const auto* lone : {R"(\ud83d)", R"(\ud83dx)", R"(\ud83dA)", R"(\ude00)", R"(\ude00\ud83d)", R"(\u12)", R"(\q)"}) {
+        CHECK(not check_escapes(lone));
+        CHECK(escape_length(lone) == 0);
+        CHECK(scan_string_literal(std::string(lone) + "\"").has_invalid_escape);
+
+        const auto document = std::string(R"({"k":")") + lone + R"("})";
+
+        CHECK(is_error(JsonParser::parse(document)));
+        CHECK(is_error(JsonValidator::validate(document)));
+    }
+
+    CHECK(not is_error(JsonParser::parse(R"({"k":"\ud83d\ude00"})")));
+    CHECK(not is_error(JsonValidator::validate(R"({"k":"\ud83d\ude00"})")));
+}
+
+auto test_utf8_at_block_boundaries() -> void {
+    const std::vector<std::string> valid = {"\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xf4\x8f\xbf\xbf"};
+    const std::vector<std::string> invalid = {
+        "\xc3", "\xe2\x82", "\xf0\x9f\x98",
+        "\xc0\xaf", "\xe0\x80\xaf", "\xf0\x80\x80\xaf",
+        "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xf5\x80\x80\x80", "\x80", "\xfe",
+    };
+
+    // every position around the 16 and 32 byte blocks, at the end of the
+    // text and followed by more ascii.
+    for (std::size_t prefix = 0; prefix < 70; prefix++) {
+        for (const auto* suffix : {"", "tail"}) {
+            for (const auto level : levels) {
+                for (const auto& sequence : valid) {
+                    const auto text = std::string(prefix, 'x') + sequence + suffix;
+
+                    CHECK(validate_utf8(text, level));
+                    CHECK(utf8_sequence_length(sequence) == sequence.length());
+                }
+
+                for (const auto& sequence : invalid) {
+                    const auto text = std::string(prefix, 'x') + sequence + suffix;
+
+                    CHECK(not validate_utf8(text, level));
+                    CHECK(utf8_sequence_length(sequence) == 0);
+                }
+            }
+        }
+    }
+}
+
+// the string back out of {"k": ...}.
+auto parse_member(std::string_view document) -> std::string {
+    const auto result = JsonParser::parse(document);
+
+    if (is_error(result))
+        return "error";
+
+    std::string text;
+
+    std::get<JsonObject>(result).access([&text](const JsonObjectDict& dict) {
+            if (const auto found = dict.find("k"); found != dict.end())
+                text = static_cast<const JsonString&>(*found->second).view();
+            });
+
+    return text;
+}
+
+auto write_member(std::string_view text, bool ascii_only) -> std::string {
+    JsonWriter writer(JsonWriterOptions{.ascii_only = ascii_only});
+
+    writer.start_object();
+    writer.write_key("k");
+    writer.write_string(text);
+    writer.end_object();
+
+    return writer.take();
+}
+
+auto test_writer_round_trip() -> void {
+    std::mt19937 random(21);
+
+    const std::vector<std::string> samples = {
+        "", "plain", "quote \" and backslash \\", "\n\r\t\b\f\x01\x1f\x7f",
+        "caf\xc3\xa9", "\xe2\x82\xac 5", "emoji \xf0\x9f\x98\x80", "\xf4\x8f\xbf\xbf",
+        std::string(31, 'x') + "\xf0\x9f\x98\x80" + std::string(40, 'y') + "\"",
+    };
+
+    // decoded text the writer has to escape, invalid utf-8 is left out as it
+    // comes back as U+FFFD.
+    const auto valid = utf8_fragments();
+
+    for (std::size_t round = 0; round < 600 + samples.size(); round++) {
+        std::string text;
+
+        if (round < samples.size())
+            text = samples[round];
+        else
+            text = random_string(random, valid, round % 40);
+
+        for (const auto ascii_only : {false, true}) {
+            const auto written = write_member(text, ascii_only);
+
+            CHECK(parse_member(written) == text);
+            CHECK(not is_error(JsonValidator::validate(written)));
+
+            if (ascii_only) {
+                for (const auto c : written)
+                    CHECK(static_cast<unsigned char>(c) < 0x80);
+            }
+        }
+    }
+
+    CHECK(write_member("\xf0\x9f\x98\x80", true) == R"({"k":"\ud83d\ude00"})");
+    CHECK(write_member("caf\xc3\xa9", true) == R"({"k":"caf\u00e9"})");
+    CHECK(write_member("caf\xc3\xa9", false) == "{\"k\":\"caf\xc3\xa9\"}");
+    CHECK(write_member("\xff", true) == R"({"k":"\ufffd"})");
+}
+
+}
+
+auto main() -> int {
+    test_levels_match_scalar();
+    test_surrogates();
+    test_utf8_at_block_boundaries();
+    test_writer_round_trip();
+
+    return check_result();
+}
@@ -0,0 +1,123 @@
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "ndjson.h"
+
+namespace {
+
+// line i holds {"i":i}, every third line is followed by a blank one and
+// every seventh has a second object after it.
+auto make_input(std::size_t lines) -> std::string {
+    std::string input;
+
+    for (std::size_t i = 0; i < lines; i++) {
+        input += R"({"i":)" + std::to_string(i) + "}";
+
+        if (i % 7 == 3)
+            input += R"( {"extra":true})";
+
+        input += i % 2 == 0 ? "\n" : " \r\n";
+
+        if (i % 3 == 0)
+            input += " \t\n\n";
+    }
+
+    return input;
+}
+
+// records holds the records in any order, they are checked by index.
+auto check_records(std::string_view input, const NdjsonResult& result, const std::vector<NdjsonRecord>& records, std::size_t lines) -> void {
+    CHECK(result.record_count == lines);
+    CHECK(result.error_count == (lines + 3) / 7);
+    CHECK(records.size() == lines);
+
+    std::vector<const NdjsonRecord*> by_index(records.size());
+
+    for (const auto& record : records) {
+        if (record.index < by_index.size())
+            by_index[record.index] = &record;
+    }
+
+    for (std::size_t i = 0; i < by_index.size(); i++) {
+        CHECK(by_index[i]);
+
+        if (not by_index[i])
+            continue;
+
+        const auto& record = *by_index[i];
+
+        CHECK(input.substr(record.offset).starts_with(R"({"i":)" + std::to_string(i) + "}"));
+
+        if (i % 7 == 3) {
+            CHECK(is_error(record.result));
+        } else {
+            CHECK(not is_error(record.result)
+                    and std::get<JsonObject>(record.result).serialize() == R"({"i":)" + std::to_string(i) + "}");
+        }
+    }
+}
+
+auto test_records() -> void {
+    constexpr std::size_t lines = 500;
+
+    const auto input = make_input(lines);
+
+    for (const auto threads : {1, 4}) {
+        for (const auto batch_bytes : {1, 64, 1 << 20}) {
+            const auto options = NdjsonOptions{.threads = static_cast<std::size_t>(threads), .batch_bytes = static_cast<std::size_t>(batch_bytes)};
+
+            const auto result = parse_many(input, options);
+
+            check_records(input, result, result.records, lines);
+
+            for (std::size_t i = 0; i < result.records.size(); i++)
+                CHECK(result.records[i].index == i);
+        }
+    }
+}
+
+auto test_trailing_content() -> void {
+    const auto result = parse_many("{\"a\":1} {\"b\":2}\n{\"a\":1} \n{\"a\":1}x\n{\"a\":1}}\n");
+
+    CHECK(result.record_count == 4);
+    CHECK(result.error_count == 3);
+    CHECK(result.records.size() == 4 and not is_error(result.records[1].result));
+}
+
+auto test_delivery() -> void {
+    constexpr std::size_t lines = 400;
+
+    const auto input = make_input(lines);
+
+    for (const auto ordered : {true, false}) {
+        std::vector<NdjsonRecord> records;
+
+        const auto options = NdjsonOptions{.threads = 4, .batch_bytes = 32, .ordered = ordered};
+
+        // the callback is never called on two threads at once, so no lock.
+        const auto result = parse_many(input, options, [&records](NdjsonRecord&& record) {
+                records.push_back(std::move(record));
+                });
+
+        CHECK(result.records.empty());
+
+        if (ordered) {
+            for (std::size_t i = 0; i < records.size(); i++)
+                CHECK(records[i].index == i);
+        }
+
+        // unordered still numbers every record by its place in the input.
+        check_records(input, result, records, lines);
+    }
+}
+
+}
+
+auto main() -> int {
+    test_records();
+    test_trailing_content();
+    test_delivery();
+
+    return check_result();
+}
@@ -0,0 +1,150 @@
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <string>
+
+#include "check.h"
+#include "number.h"
+#include "parser.h"
+
+namespace {
+
+auto same_double(std::optional<double> lhs, double rhs) -> bool {
+    return lhs and std::bit_cast<std::uint64_t>(*lhs) == std::bit_cast<std::uint64_t>(rhs);
+}
+
+auto format(NumberValue number) -> std::string {
+    char buffer[max_number_length];
+
+    return std::string(buffer, std::visit([&buffer](auto value) {
+                return format_number(value, buffer);
+                }, number));
+}
+
+auto round_trip(std::string_view literal) -> std::string {
+    std::string document = R"({"n":)";
+
+    document += literal;
+    document += '}';
+
+    const auto result = JsonParser::parse(document);
+
+    if (is_error(result))
+        return "error";
+
+    const auto text = std::get<JsonObject>(result).serialize();
+
+    return text.substr(5, text.length() - 6);
+}
+
+auto test_literals() -> void {
+    CHECK(scan_number("-0") == 2);
+    CHECK(scan_number("1e-9,") == 4);
+    CHECK(scan_number("01") == 1);
+    CHECK(scan_number("1.") == 0);
+    CHECK(scan_number(".5") == 0);
+    CHECK(scan_number("-") == 0);
+    CHECK(scan_number("1e") == 0);
+
+    CHECK(std::get<double>(*parse_number_value("-0")) == 0.0);
+    CHECK(std::signbit(std::get<double>(*parse_number_value("-0"))));
+    CHECK(same_double(parse_number("1e-9"), 1e-9));
+    CHECK(same_double(parse_number("0.1"), 0.1));
+    CHECK(same_double(parse_number("1e-400"), 0.0));
+    CHECK(same_double(parse_number("-1e-400"), -0.0));
+
+    CHECK(std::get<std::int64_t>(*parse_number_value("9007199254740993")) == 9007199254740993);
+    CHECK(std::get<std::uint64_t>(*parse_number_value("18446744073709551615")) == std::numeric_limits<std::uint64_t>::max());
+    CHECK(std::get<std::int64_t>(*parse_number_value("-9223372036854775808")) == std::numeric_limits<std::int64_t>::min());
+
+    // past 64 bits integers become doubles.
+    CHECK(std::get<double>(*parse_number_value("18446744073709551616")) == 18446744073709551616.0);
+    CHECK(std::get<double>(*parse_number_value("-9223372036854775809")) == -9223372036854775808.0);
+
+    // too large for a double.
+    CHECK(not parse_number("1e400"));
+    CHECK(not parse_number_value("-1e400"));
+    CHECK(not parse_number_value("1" + std::string(400, '0')));
+
+    for (const auto* malformed : {"01", "-01", "1.", ".5", "+1", "1e+", "0x1", ""}) {
+        CHECK(not parse_number(malformed));
+        CHECK(not parse_number_value(malformed));
+        CHECK(round_trip(malformed) == "error");
+    }
+}
+
+auto test_exact_round_trips() -> void {
+    for (const auto* literal : {
+                "0", "-0", "1e-9", "9007199254740993", "18446744073709551615", "-9223372036854775808",
+                "0.1", "1.7976931348623157e+308", "5e-324", "123456789012345680"}) {
+        CHECK(round_trip(literal) == format(*parse_number_value(literal)));
+    }
+
+    CHECK(round_trip("9007199254740993") == "9007199254740993");
+    CHECK(round_trip("18446744073709551615") == "18446744073709551615");
+    CHECK(round_trip("-9223372036854775808") == "-9223372036854775808");
+    CHECK(round_trip("-0") == "-0");
+    CHECK(round_trip("1e400") == "error");
+}
+
+// the fast path against from_chars on literals of every shape, and the
+// shortest text of random doubles read back bit for bit.
+auto test_random() -> void {
+    std::mt19937_64 random(9);
+
+    std::uniform_int_distribution<int> digit_count(1, 24);
+    std::uniform_int_distribution<int> exponent(-340, 320);
+    std::uniform_int_distribution<int> digit(0, 9);
+
+    for (int round = 0; round < 20000; round++) {
+        std::string literal = round % 2 ? "-" : "";
+
+        const auto integral = digit_count(random);
+
+        for (int i = 0; i < integral; i++)
+            literal += static_cast<char>('0' + (i == 0 and integral > 1 ? 1 + digit(random) % 9 : digit(random)));
+
+        if (round % 3 != 0) {
+            literal += '.';
+
+            for (int i = digit_count(random); i > 0; i--)
+                literal += static_cast<char>('0' + digit(random));
+        }
+
+        if (round % 5 != 0) {
+            literal += 'e';
+            literal += std::to_string(round % 4 == 0 ? exponent(random) : exponent(random) / 20);
+        }
+
+        double expected = 0.0;
+
+        const auto [ptr, error] = std::from_chars(literal.data(), literal.data() + literal.length(), expected);
+
+        if (error == std::errc())
+            CHECK(same_double(parse_number(literal), expected));
+        else
+            CHECK(not parse_number(literal) or *parse_number(literal) == 0.0);
+
+        const auto bits = random();
+        const auto number = std::bit_cast<double>(bits);
+
+        if (not std::isfinite(number))
+            continue;
+
+        char buffer[max_number_length];
+
+        CHECK(same_double(parse_number(std::string_view(buffer, format_number(number, buffer))), number));
+    }
+}
+
+}
+
+auto main() -> int {
+    test_literals();
+    test_exact_round_trips();
+    test_random();
+
+    return check_result();
+}
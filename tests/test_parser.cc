@@ -0,0 +1,59 @@
+#include "check.h"
+#include "parser.h"
+#include "push.h"
+#include "sax.h"
+#include "validate.h"
+
+namespace {
+
+auto round_trip(std::string_view input) -> std::string {
+    const auto result = JsonParser::parse(input);
+
+    if (is_error(result))
+        return "error";
+
+    return std::get<JsonObject>(result).serialize();
+}
+
+auto test_nested_arrays() -> void {
+    // the inner array used to shadow the outer one and was pushed into itself.
+    CHECK(round_trip(R"({"a":[[1,2],[3,[4,[]]],[]]})") == R"({"a":[[1,2],[3,[4,[]]],[]]})");
+    CHECK(round_trip(R"({"a":[[[[]]]]})") == R"({"a":[[[[]]]]})");
+}
+
+// fed one byte at a time, so every token straddles chunks.
+auto push_accepts(std::string_view input) -> bool {
+    JsonSaxHandler handler;
+    JsonPushParser<JsonSaxHandler> parser(handler);
+
+    for (const auto c : input) {
+        if (is_error(parser.feed(std::string_view(&c, 1))))
+            return false;
+    }
+
+    return not is_error(parser.finish());
+}
+
+auto test_entry_points_agree() -> void {
+    const char* inputs[] = {
+        R"({"a":true})", R"({"a" : [1, null ,false]} )", "{\"a\":\r\n\t1}",
+        R"({"a":true1})", R"({"a":null1})", R"({"a":falsex})", R"({"a":"s"x})",
+        "{\"a\":[1\v]}", "{\"a\":\f1}", "{\"a\":true\v}", R"({"a":01})",
+    };
+
+    for (const auto* input : inputs) {
+        const auto valid = not is_error(JsonValidator::validate(input));
+
+        CHECK(not is_error(JsonParser::parse(input)) == valid);
+        CHECK(push_accepts(input) == valid);
+    }
+}
+
+}
+
+auto main() -> int {
+    test_nested_arrays();
+    test_entry_points_agree();
+
+    return check_result();
+}
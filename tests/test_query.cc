@@ -0,0 +1,99 @@
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "parser.h"
+#include "query.h"
+
+namespace {
+
+const std::string document = R"({
+    "a\u0062": 1,
+    "plain": {"x\ty": [10, 20, {"\u00e9té": "summer"}]},
+    "list": [{"k": 1}, {"\u006b": 2}, {"k\"": 3}],
+    "emoji \ud83d\ude00": true
+})";
+
+// every match, serialized, from the tree and from the raw text.
+auto tree_results(const JsonQuery& query) -> std::string {
+    const auto root = std::get<JsonObject>(JsonParser::parse(document));
+
+    std::string result;
+
+    for (const auto* value : query.evaluate(root))
+        result += value->serialize() + ";";
+
+    return result;
+}
+
+auto text_results(const JsonQuery& query) -> std::string {
+    const auto values = query.evaluate(std::string_view(document));
+
+    if (is_error(values))
+        return "error";
+
+    std::string result;
+
+    for (const auto& value : std::get<1>(values)) {
+        const auto parsed = value.to_value();
+
+        if (is_error(parsed))
+            return "error";
+
+        result += std::get<1>(parsed)->serialize() + ";";
+    }
+
+    return result;
+}
+
+auto test_tree_and_text_agree() -> void {
+    const char* expressions[] = {
+        "$.ab", "$['ab']", "/ab", "$.plain['x\ty']", "/plain/x\ty/2/\xc3\xa9t\xc3\xa9",
+        "$.plain['x\ty'][2]['\xc3\xa9t\xc3\xa9']", "$.list[*].k", "$..k", "$.list[2]['k\"']",
+        "$['emoji \xf0\x9f\x98\x80']", "$.*", "$..*", "$.missing", "/list/1/k",
+    };
+
+    for (const auto* expression : expressions) {
+        const auto query = JsonQuery::compile(expression);
+
+        CHECK(not is_error(query));
+
+        if (is_error(query))
+            continue;
+
+        const auto& compiled = std::get<JsonQuery>(query);
+
+        CHECK(tree_results(compiled) == text_results(compiled));
+    }
+
+    const auto ab = std::get<JsonQuery>(JsonQuery::compile("$.ab"));
+
+    CHECK(text_results(ab) == "1;");
+    CHECK(text_results(std::get<JsonQuery>(JsonQuery::compile("$..k"))) == "1;2;");
+}
+
+auto test_lazy_keys() -> void {
+    const auto lazy = std::get<JsonLazyDocument>(JsonParser::parse_lazy(document));
+
+    CHECK(not is_error(lazy.find("ab")));
+    CHECK(is_error(lazy.find("a\\u0062")));
+
+    const auto members = std::get<1>(lazy.root().members());
+
+    CHECK(members.size() == 4 and members[0].first == "ab" and members[3].first == "emoji \xf0\x9f\x98\x80");
+
+    // a key with a broken escape is an error, not a key that never matches.
+    const auto broken = std::get<JsonLazyDocument>(JsonParser::parse_lazy(R"({"a\x": 1, "b": 2})"));
+
+    CHECK(is_error(broken.root().try_find("b")));
+    CHECK(is_error(broken.root().members()));
+}
+
+}
+
+auto main() -> int {
+    test_tree_and_text_agree();
+    test_lazy_keys();
+
+    return check_result();
+}
@@ -0,0 +1,136 @@
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+
+#include <unistd.h>
+
+#include "check.h"
+#include "tape_image.h"
+
+namespace {
+
+const auto document = std::string(R"({"name":"tape","list":[1,-2,18446744073709551615,0.5,true,false,null],)")
+    + R"("nested":{"a":{"b":[[],{},"deep"]},"":""},"text":"café"})";
+
+auto temporary_path(std::string_view name) -> std::string {
+    return "/tmp/test_tape_image_" + std::to_string(::getpid()) + "_" + std::string(name);
+}
+
+auto write_file(const std::string& path, std::string_view contents) -> void {
+    std::ofstream(path, std::ios::binary).write(contents.data(), static_cast<std::streamsize>(contents.length()));
+}
+
+auto image_of(std::string_view input) -> std::string {
+    return JsonTapeImage::serialize(std::get<JsonTape>(JsonTape::parse(input)));
+}
+
+// opens the image and walks all of it, what comes out is only looked at
+// to make sure the walk really happens.
+auto open_and_walk(const std::string& path, bool verify_checksum) -> std::string {
+    const auto image = JsonTapeImage::open(path, JsonTapeImageOptions{.verify_checksum = verify_checksum});
+
+    if (is_error(image))
+        return "error";
+
+    return std::get<JsonTapeImage>(image).root().to_value()->serialize();
+}
+
+auto test_save_and_open() -> void {
+    const auto path = temporary_path("saved");
+    const auto tape = std::get<JsonTape>(JsonTape::parse(document));
+
+    CHECK(not is_error(JsonTapeImage::save(tape, path)));
+
+    const auto expected = tape.to_value()->serialize();
+
+    CHECK(open_and_walk(path, true) == expected);
+    CHECK(open_and_walk(path, false) == expected);
+
+    const auto image = std::get<JsonTapeImage>(JsonTapeImage::open(path));
+
+    CHECK(image.root().find("nested")->find("a")->find("b")->at(2)->as_string() == "deep");
+    CHECK(image.root().find("list")->at(2)->as_uint64() == 18446744073709551615u);
+
+    std::remove(path.c_str());
+}
+
+auto test_truncated() -> void {
+    const auto path = temporary_path("truncated");
+    const auto image = image_of(document);
+
+    for (std::size_t length = 0; length < image.length(); length++) {
+        write_file(path, std::string_view(image).substr(0, length));
+
+        CHECK(open_and_walk(path, false) == "error");
+    }
+
+    std::remove(path.c_str());
+}
+
+// a damaged image either fails to open or walks without reading past its
+// end, meant to be run under -DJSON_SANITIZE=address as well.
+auto test_corrupted() -> void {
+    const auto path = temporary_path("corrupted");
+
+    const auto image = image_of(document);
+    const auto header_size = 48;
+
+    std::mt19937 random(23);
+
+    for (std::size_t position = header_size; position < image.length(); position++) {
+        for (int round = 0; round < 4; round++) {
+            auto damaged = image;
+
+            // the tag bytes and the low bytes of the payloads matter most.
+            const auto byte = round == 0 ? '\xff' : static_cast<char>(random());
+
+            damaged[position] = byte;
+
+            if (damaged == image)
+                continue;
+
+            write_file(path, damaged);
+
+            CHECK(open_and_walk(path, true) == "error");
+
+            open_and_walk(path, false);
+        }
+    }
+
+    std::remove(path.c_str());
+}
+
+auto test_tape_structure() -> void {
+    const auto tape = std::get<JsonTape>(JsonTape::parse(document));
+    const auto words = std::span<const std::uint64_t>(tape.tape());
+
+    CHECK(is_well_formed_tape(words, tape.strings()));
+    CHECK(not is_well_formed_tape(words.first(0), tape.strings()));
+    CHECK(not is_well_formed_tape(words.first(words.size() - 1), tape.strings()));
+    CHECK(not is_well_formed_tape(words.subspan(1), tape.strings()));
+    CHECK(not is_well_formed_tape(words, std::string_view(tape.strings()).substr(0, tape.strings().length() - 1)));
+
+    // two values where one is expected.
+    auto twice = tape.tape();
+
+    twice.insert(twice.end(), tape.tape().begin(), tape.tape().end());
+
+    CHECK(not is_well_formed_tape(twice, tape.strings()));
+
+    const auto scalar = std::get<JsonTape>(JsonTape::parse("[\"s\"]"));
+
+    CHECK(is_well_formed_tape(scalar.tape(), scalar.strings()));
+    CHECK(is_well_formed_tape(std::span<const std::uint64_t>(scalar.tape()).subspan(1, 1), scalar.strings()));
+}
+
+}
+
+auto main() -> int {
+    test_save_and_open();
+    test_truncated();
+    test_corrupted();
+    test_tape_structure();
+
+    return check_result();
+}
@@ -0,0 +1,97 @@
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "writer.h"
+
+namespace {
+
+auto write_sample(JsonWriter& writer) -> void {
+    writer.start_object();
+    writer.write_key("abcdefgh");
+    writer.start_array();
+    writer.write_string("a longer string than any of the small buffers");
+    writer.write_int64(-42);
+    writer.write_null();
+    writer.start_object();
+    writer.end_object();
+    writer.end_array();
+    writer.end_object();
+}
+
+auto expected(JsonWriterOptions options) -> std::string {
+    JsonWriter writer(options);
+
+    write_sample(writer);
+
+    return writer.take();
+}
+
+auto test_buffers() -> void {
+    for (const auto pretty : {false, true}) {
+        const auto options = JsonWriterOptions{.pretty = pretty};
+        const auto output = expected(options);
+
+        CHECK(output.starts_with(R"({)") and output.find("abcdefgh") != std::string::npos);
+
+        for (const std::size_t size : {0, 1, 4, 1024}) {
+            std::vector<char> buffer(size);
+
+            // no sink, the writer outgrows the buffer and keeps what was in it.
+            {
+                JsonWriter writer(std::span<char>(buffer), nullptr, options);
+
+                write_sample(writer);
+
+                CHECK(writer.view() == output);
+                CHECK(writer.take() == output);
+            }
+
+            std::string sunk;
+
+            {
+                JsonWriter writer(std::span<char>(buffer), [&sunk](std::string_view data) {
+                        sunk += data;
+                        }, options);
+
+                write_sample(writer);
+            }
+
+            CHECK(sunk == output);
+        }
+
+        std::string sunk;
+
+        {
+            JsonWriter writer([&sunk](std::string_view data) {
+                    sunk += data;
+                    }, options);
+
+            write_sample(writer);
+        }
+
+        CHECK(sunk == output);
+    }
+}
+
+auto test_small_buffer_without_sink() -> void {
+    char buffer[4];
+
+    JsonWriter writer(std::span<char>(buffer), nullptr);
+
+    writer.start_array();
+    writer.write_string("abcdefgh");
+    writer.end_array();
+
+    CHECK(writer.view() == R"(["abcdefgh"])");
+    CHECK(writer.take() == R"(["abcdefgh"])");
+}
+
+}
+
+auto main() -> int {
+    test_buffers();
+    test_small_buffer_without_sink();
+
+    return check_result();
+}
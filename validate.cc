@@ -0,0 +1,285 @@
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "escape.h"
+#include "number.h"
+#include "stats.h"
+#include "validate.h"
+
+namespace {
+
+auto is_whitespace(char c) -> bool {
+    return c == ' ' or c == '\t' or c == '\n' or c == '\r';
+}
+
+// printable ascii other than '"' and '\\', the bytes a string can be made
+// of without a closer look.
+auto is_plain(char c) -> bool {
+    const auto byte = static_cast<unsigned char>(c);
+
+    return byte >= 0x20 and byte < 0x80 and c != '"' and c != '\\';
+}
+
+// first byte at or after begin that is not plain. strings are mostly plain
+// ascii, so they are stepped over 16 bytes at a time. sse2 is part of
+// x86_64, no detection needed.
+auto skip_plain(const char* begin, const char* end) -> const char* {
+#if defined(__x86_64__)
+    while (end - begin >= 16) {
+        const auto chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+
+        // a signed compare, bytes from 0x80 up are negative and drop out
+        // together with the control characters.
+        const auto printable = _mm_cmpgt_epi8(chunk, _mm_set1_epi8(0x1f));
+        const auto special = _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\')));
+        const auto plain = static_cast<unsigned>(_mm_movemask_epi8(_mm_andnot_si128(special, printable)));
+
+        if (plain != 0xffff)
+            return begin + __builtin_ctz(~plain);
+
+        begin += 16;
+    }
+#endif
+
+    while (begin != end and is_plain(*begin))
+        begin++;
+
+    return begin;
+}
+
+}
+
+auto JsonValidator::validate(std::string_view input, const JsonValidateOptions& options) -> ErrorOr<std::monostate> {
+    if (options.max_bytes != 0 and input.length() > options.max_bytes)
+        return JsonError(JsonErrorCode::InputTooLarge, options.max_bytes);
+
+    JSON_STATS(bytes_scanned += input.length());
+    JSON_PHASE(JsonPhase::Validate);
+
+    JsonValidator validator(input, options);
+
+    return validator.run();
+}
+
+auto JsonValidator::run() -> ErrorOr<std::monostate> {
+    while (true) {
+        skip_whitespaces();
+
+        if (m_position == m_input.length())
+            return error_unexpected();
+
+        switch (m_input[m_position]) {
+        case '{':
+            TRY(open_container(true));
+
+            if (m_input[m_position] != '}') {
+                TRY(scan_key());
+                continue;
+            }
+
+            m_position++;
+            m_stack.pop_back();
+            break;
+        case '[':
+            TRY(open_container(false));
+
+            if (m_input[m_position] != ']')
+                continue;
+
+            m_position++;
+            m_stack.pop_back();
+            break;
+        case '"':
+            TRY(scan_string());
+            break;
+        case 't':
+            TRY(scan_literal("true"));
+            break;
+        case 'f':
+            TRY(scan_literal("false"));
+            break;
+        case 'n':
+            TRY(scan_literal("null"));
+            break;
+        default:
+            TRY(scan_number());
+            break;
+        }
+
+        // a value is complete, close containers until a comma asks for the
+        // next one.
+        while (true) {
+            skip_whitespaces();
+
+            if (m_stack.empty()) {
+                if (m_position != m_input.length())
+                    return error_unexpected();
+
+                return std::monostate{};
+            }
+
+            if (m_position == m_input.length())
+                return error_unexpected();
+
+            const auto is_object = m_stack.back();
+            const auto c = m_input[m_position];
+
+            if (c == ',') {
+                m_position++;
+
+                if (is_object)
+                    TRY(scan_key());
+
+                break;
+            }
+
+            if (c != (is_object ? '}' : ']'))
+                return error_unexpected();
+
+            m_position++;
+            m_stack.pop_back();
+        }
+    }
+}
+
+auto JsonValidator::scan_string() -> ErrorOr<std::monostate> {
+    // skip the '"'
+    m_position++;
+
+    const auto end = m_input.data() + m_input.length();
+
+    while (true) {
+        m_position = static_cast<std::size_t>(skip_plain(m_input.data() + m_position, end) - m_input.data());
+
+        if (m_position == m_input.length())
+            return error_unexpected();
+
+        const auto byte = static_cast<unsigned char>(m_input[m_position]);
+
+        if (byte == '"') {
+            m_position++;
+            return std::monostate{};
+        }
+
+        if (byte == '\\')
+            TRY(scan_escape());
+        else if (byte < 0x20)
+            return error_unexpected();
+        else
+            TRY(scan_utf8());
+    }
+}
+
+auto JsonValidator::scan_escape() -> ErrorOr<std::monostate> {
+    const auto rest = m_input.substr(m_position);
+
+    if (rest.length() < 2)
+        return JsonError(JsonErrorCode::UnexpectedEndOfFile, m_input.length());
+
+    const auto length = escape_length(rest);
+
+    if (length != 0) {
+        m_position += length;
+        return std::monostate{};
+    }
+
+    // the context is the broken escape, the broken \u escape, or a high
+    // surrogate with what should have been its low half.
+    auto context = rest.substr(0, 2);
+
+    if (rest[1] == 'u')
+        context = rest.substr(0, is_high_surrogate(parse_unicode_escape(rest)) ? 12 : 6);
+
+    return JsonError(JsonErrorCode::InvalidEscape, m_position, context);
+}
+
+// one multi byte sequence, rejecting overlong forms, encoded surrogates and
+// anything past U+10FFFF.
+auto JsonValidator::scan_utf8() -> ErrorOr<std::monostate> {
+    const auto length = utf8_sequence_length(m_input.substr(m_position));
+
+    if (length == 0)
+        return JsonError(JsonErrorCode::InvalidUtf8, m_position);
+
+    m_position += length;
+
+    return std::monostate{};
+}
+
+auto JsonValidator::scan_literal(std::string_view literal) -> ErrorOr<std::monostate> {
+    for (const auto c : literal) {
+        if (m_position == m_input.length() or m_input[m_position] != c)
+            return error_unexpected();
+
+        m_position++;
+    }
+
+    return std::monostate{};
+}
+
+auto JsonValidator::scan_number() -> ErrorOr<std::monostate> {
+    const auto length = ::scan_number(m_input.substr(m_position));
+
+    // what follows the number is checked with the next token, "01" or
+    // "1.5.2" fail there.
+    if (length == 0)
+        return error_unexpected();
+
+    m_position += length;
+
+    return std::monostate{};
+}
+
+auto JsonValidator::scan_key() -> ErrorOr<std::monostate> {
+    skip_whitespaces();
+
+    if (m_position == m_input.length() or m_input[m_position] != '"')
+        return error_unexpected();
+
+    TRY(scan_string());
+
+    skip_whitespaces();
+
+    if (m_position == m_input.length() or m_input[m_position] != ':')
+        return error_unexpected();
+
+    m_position++;
+
+    return std::monostate{};
+}
+
+// steps into the container at the current position and onto whatever
+// comes first inside it.
+auto JsonValidator::open_container(bool is_object) -> ErrorOr<std::monostate> {
+    if (m_stack.size() == m_options.max_depth)
+        return JsonError(JsonErrorCode::DepthLimitExceeded, m_position);
+
+    m_stack.push_back(is_object);
+    m_position++;
+
+    skip_whitespaces();
+
+    if (m_position == m_input.length())
+        return error_unexpected();
+
+    return std::monostate{};
+}
+
+auto JsonValidator::skip_whitespaces() -> void {
+    while (m_position < m_input.length() and is_whitespace(m_input[m_position]))
+        m_position++;
+}
+
+auto JsonValidator::error_unexpected() const -> JsonError {
+    if (m_position >= m_input.length())
+        return JsonError(JsonErrorCode::UnexpectedEndOfFile, m_input.length());
+
+    const auto c = m_input[m_position];
+
+    // control characters and stray utf-8 are left out of the message.
+    if (not is_plain(c) and c != '"' and c != '\\')
+        return JsonError(JsonErrorCode::UnexpectedCharacter, m_position);
+
+    return JsonError(JsonErrorCode::UnexpectedCharacter, m_position, m_input.substr(m_position, 1));
+}
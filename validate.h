@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include "error.h"
+
+struct JsonValidateOptions {
+    // inputs longer than this are rejected before looking at them, zero
+    // means no limit.
+    std::size_t max_bytes{0};
+
+    // objects and arrays nested deeper than this are rejected, a top level
+    // container is at depth 1.
+    std::size_t max_depth{1024};
+};
+
+// Answers "is this one well formed json value" without building anything:
+// no tokens, no index and no JsonValues. Checks the full RFC 8259 grammar,
+// any value is accepted at the top level, along with escape sequences
+// (surrogates have to come in pairs) and the utf-8 inside strings. The
+// first problem found is reported with its byte offset.
+class JsonValidator {
+public:
+    static auto validate(std::string_view input, const JsonValidateOptions& options = {}) -> ErrorOr<std::monostate>;
+
+private:
+    JsonValidator(std::string_view input, const JsonValidateOptions& options)
+        : m_input(input), m_options(options) {}
+
+    auto run() -> ErrorOr<std::monostate>;
+
+    auto scan_string() -> ErrorOr<std::monostate>;
+
+    auto scan_escape() -> ErrorOr<std::monostate>;
+
+    auto scan_utf8() -> ErrorOr<std::monostate>;
+
+    auto scan_literal(std::string_view literal) -> ErrorOr<std::monostate>;
+
+    auto scan_number() -> ErrorOr<std::monostate>;
+
+    // a string, then the ':' that follows every key.
+    auto scan_key() -> ErrorOr<std::monostate>;
+
+    auto open_container(bool is_object) -> ErrorOr<std::monostate>;
+
+    auto skip_whitespaces() -> void;
+
+    auto error_unexpected() const -> JsonError;
+
+private:
+    std::string_view m_input;
+    std::size_t m_position{0};
+
+    JsonValidateOptions m_options;
+
+    // one entry per open container, true for objects.
+    std::vector<bool> m_stack;
+};
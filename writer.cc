@@ -0,0 +1,365 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "escape.h"
+#include "jsonval.h"
+#include "number.h"
+#include "writer.h"
+
+JsonWriter::JsonWriter(JsonWriterOptions options)
+    : m_options(options)
+{
+    m_storage.resize(256);
+    m_buffer = m_storage.data();
+    m_capacity = m_storage.size();
+}
+
+JsonWriter::JsonWriter(Sink sink, JsonWriterOptions options)
+    : m_options(options), m_sink(std::move(sink))
+{
+    m_storage.resize(default_buffer_size);
+    m_buffer = m_storage.data();
+    m_capacity = m_storage.size();
+}
+
+JsonWriter::JsonWriter(std::span<char> buffer, Sink sink, JsonWriterOptions options)
+    : m_options(options), m_sink(std::move(sink)), m_buffer(buffer.data()), m_capacity(buffer.size()) {}
+
+JsonWriter::JsonWriter(std::ostream& stream, JsonWriterOptions options)
+    : JsonWriter([&stream](std::string_view data) {
+            stream.write(data.data(), static_cast<std::streamsize>(data.length()));
+            }, options) {}
+
+JsonWriter::~JsonWriter() {
+    flush();
+}
+
+auto JsonWriter::fd_sink(int fd) -> Sink {
+    return [fd](std::string_view data) {
+        while (not data.empty()) {
+            const auto count = ::write(fd, data.data(), data.length());
+
+            if (count < 0) {
+                if (errno == EINTR)
+                    continue;
+
+                return;
+            }
+
+            data.remove_prefix(static_cast<std::size_t>(count));
+        }
+    };
+}
+
+auto JsonWriter::write(const JsonValue& value) -> void {
+    value.write(*this);
+}
+
+auto JsonWriter::write_null() -> void {
+    before_value();
+    append("null");
+}
+
+auto JsonWriter::write_bool(bool boolean) -> void {
+    before_value();
+    append(boolean ? "true" : "false");
+}
+
+auto JsonWriter::write_number(double number) -> void {
+    before_value();
+
+    char buffer[max_number_length];
+
+    append(std::string_view(buffer, format_number(number, buffer)));
+}
+
+auto JsonWriter::write_int64(std::int64_t number) -> void {
+    before_value();
+
+    char buffer[max_number_length];
+
+    append(std::string_view(buffer, format_number(number, buffer)));
+}
+
+auto JsonWriter::write_uint64(std::uint64_t number) -> void {
+    before_value();
+
+    char buffer[max_number_length];
+
+    append(std::string_view(buffer, format_number(number, buffer)));
+}
+
+auto JsonWriter::write_string(std::string_view string) -> void {
+    before_value();
+
+    put('"');
+    append_escaped(string);
+    put('"');
+}
+
+auto JsonWriter::write_key(std::string_view key) -> void {
+    if (m_needs_comma)
+        put(',');
+
+    newline();
+
+    put('"');
+    append_escaped(key);
+    put('"');
+    put(':');
+
+    if (m_options.pretty)
+        put(' ');
+
+    m_needs_comma = false;
+    m_after_key = true;
+}
+
+auto JsonWriter::start_object() -> void {
+    before_value();
+    put('{');
+
+    m_depth++;
+    m_needs_comma = false;
+}
+
+auto JsonWriter::end_object() -> void {
+    close_container('}');
+}
+
+auto JsonWriter::start_array() -> void {
+    before_value();
+    put('[');
+
+    m_depth++;
+    m_needs_comma = false;
+}
+
+auto JsonWriter::end_array() -> void {
+    close_container(']');
+}
+
+auto JsonWriter::flush() -> void {
+    if (not m_sink or m_size == 0)
+        return;
+
+    m_sink(std::string_view(m_buffer, m_size));
+    m_size = 0;
+}
+
+auto JsonWriter::view() const -> std::string_view {
+    return std::string_view(m_buffer, m_size);
+}
+
+auto JsonWriter::take() -> std::string {
+    // still in the caller's buffer, it has not filled up yet.
+    if (m_buffer != m_storage.data())
+        m_storage.assign(view());
+
+    m_storage.resize(m_size);
+
+    auto result = std::move(m_storage);
+
+    m_storage.resize(256);
+    m_buffer = m_storage.data();
+    m_capacity = m_storage.size();
+    m_size = 0;
+
+    return result;
+}
+
+auto JsonWriter::before_value() -> void {
+    if (m_after_key) {
+        m_after_key = false;
+    } else {
+        if (m_needs_comma)
+            put(',');
+
+        if (m_depth > 0)
+            newline();
+    }
+
+    // whatever comes next in the enclosing container needs a separator.
+    m_needs_comma = true;
+}
+
+auto JsonWriter::close_container(char c) -> void {
+    m_depth--;
+
+    // empty containers stay on one line.
+    if (m_needs_comma)
+        newline();
+
+    put(c);
+
+    m_needs_comma = true;
+}
+
+auto JsonWriter::newline() -> void {
+    if (not m_options.pretty)
+        return;
+
+    const auto width = m_depth * m_options.indent;
+
+    if (not reserve(width + 1)) {
+        put('\n');
+
+        for (std::size_t i = 0; i < width; i++)
+            put(' ');
+
+        return;
+    }
+
+    m_buffer[m_size++] = '\n';
+    std::memset(m_buffer + m_size, ' ', width);
+    m_size += width;
+}
+
+auto JsonWriter::put(char c) -> void {
+    if (m_size == m_capacity and not reserve(1)) {
+        // a zero sized buffer, the byte goes to the sink on its own. only
+        // writers with a sink can fail to reserve.
+        m_sink(std::string_view(&c, 1));
+        return;
+    }
+
+    m_buffer[m_size++] = c;
+}
+
+auto JsonWriter::append(std::string_view data) -> void {
+    // a zero sized buffer may not even have an address.
+    if (data.empty())
+        return;
+
+    if (not reserve(data.length())) {
+        // larger than the whole buffer, send it to the sink as is.
+        flush();
+        m_sink(data);
+        return;
+    }
+
+    std::memcpy(m_buffer + m_size, data.data(), data.length());
+    m_size += data.length();
+}
+
+// strings are held decoded, quotes, backslashes and control characters go
+// back to escape sequences. the runs in between are found a block at a time
+// and appended in one go.
+auto JsonWriter::append_escaped(std::string_view string) -> void {
+    while (true) {
+        const auto next = find_escape(string, m_options.ascii_only);
+
+        append(string.substr(0, next));
+
+        if (next == string.length())
+            return;
+
+        string.remove_prefix(next);
+
+        const auto c = static_cast<unsigned char>(string[0]);
+
+        if (c < 0x80) {
+            append_escape(c);
+            string.remove_prefix(1);
+            continue;
+        }
+
+        std::uint32_t code_point = 0xfffd;
+        const auto length = decode_utf8(string, code_point);
+
+        if (code_point < 0x10000) {
+            append_unicode_escape(code_point);
+        } else {
+            code_point -= 0x10000;
+            append_unicode_escape(0xd800 | (code_point >> 10));
+            append_unicode_escape(0xdc00 | (code_point & 0x3ff));
+        }
+
+        // a stray byte is replaced on its own.
+        string.remove_prefix(length == 0 ? 1 : length);
+    }
+}
+
+auto JsonWriter::append_escape(unsigned char c) -> void {
+    static constexpr char hex[] = "0123456789abcdef";
+
+    put('\\');
+
+    switch (c) {
+    case '"':
+        put('"');
+        return;
+    case '\\':
+        put('\\');
+        return;
+    case '\b':
+        put('b');
+        return;
+    case '\f':
+        put('f');
+        return;
+    case '\n':
+        put('n');
+        return;
+    case '\r':
+        put('r');
+        return;
+    case '\t':
+        put('t');
+        return;
+    default:
+        break;
+    }
+
+    append("u00");
+    put(hex[c >> 4]);
+    put(hex[c & 0xf]);
+}
+
+// "\\uXXXX" for one utf-16 code unit.
+auto JsonWriter::append_unicode_escape(std::uint32_t unit) -> void {
+    static constexpr char hex[] = "0123456789abcdef";
+
+    const char escape[] = {
+        '\\',
+        'u',
+        hex[(unit >> 12) & 0xf],
+        hex[(unit >> 8) & 0xf],
+        hex[(unit >> 4) & 0xf],
+        hex[unit & 0xf],
+    };
+
+    append(std::string_view(escape, sizeof(escape)));
+}
+
+// makes room for length more bytes, false if that can never fit because the
+// buffer has a fixed size, which it only has with a sink.
+auto JsonWriter::reserve(std::size_t length) -> bool {
+    if (m_capacity - m_size >= length)
+        return true;
+
+    if (m_sink) {
+        flush();
+
+        return m_capacity >= length;
+    }
+
+    // a caller's buffer without a sink only gets the writer started, what
+    // is in it moves over once it fills up.
+    if (m_buffer != m_storage.data())
+        m_storage.assign(view());
+
+    auto capacity = std::max<std::size_t>(m_capacity, 1) * 2;
+
+    while (capacity - m_size < length)
+        capacity *= 2;
+
+    m_storage.resize(capacity);
+    m_buffer = m_storage.data();
+    m_capacity = capacity;
+
+    return true;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+
+class JsonValue;
+
+struct JsonWriterOptions {
+    // newlines and indentation, the compact form has no whitespace at all.
+    bool pretty{false};
+
+    std::size_t indent{4};
+
+    // everything past ascii is written as \\u escapes, surrogate pairs above
+    // U+FFFF. bytes that are not utf-8 become U+FFFD.
+    bool ascii_only{false};
+};
+
+// Serializes into a single buffer in one pass. The buffer either grows and
+// is taken with take(), or it is handed to a sink whenever it fills up and
+// reused, so writing a document costs no allocation per node.
+class JsonWriter {
+public:
+    using Sink = std::function<void(std::string_view)>;
+
+    static constexpr std::size_t default_buffer_size = 64 * 1024;
+
+    // growable in-memory buffer.
+    JsonWriter(JsonWriterOptions options = {});
+
+    // internal fixed size buffer, flushed to the sink.
+    JsonWriter(Sink sink, JsonWriterOptions options = {});
+
+    // caller provided buffer, flushed to the sink. without a sink the
+    // writer grows out of it like a growable one once it is full.
+    JsonWriter(std::span<char> buffer, Sink sink, JsonWriterOptions options = {});
+
+    JsonWriter(std::ostream& stream, JsonWriterOptions options = {});
+
+    JsonWriter(const JsonWriter& other) = delete;
+
+    auto operator=(const JsonWriter& other) -> JsonWriter& = delete;
+
+    ~JsonWriter();
+
+    // sink writing everything to a file descriptor.
+    static auto fd_sink(int fd) -> Sink;
+
+    auto write(const JsonValue& value) -> void;
+
+    auto write_null() -> void;
+
+    auto write_bool(bool boolean) -> void;
+
+    auto write_number(double number) -> void;
+
+    auto write_int64(std::int64_t number) -> void;
+
+    auto write_uint64(std::uint64_t number) -> void;
+
+    // string is the decoded text, it is escaped on the way out.
+    auto write_string(std::string_view string) -> void;
+
+    auto write_key(std::string_view key) -> void;
+
+    auto start_object() -> void;
+
+    auto end_object() -> void;
+
+    auto start_array() -> void;
+
+    auto end_array() -> void;
+
+    // hands whatever is buffered to the sink, a no-op for growable buffers.
+    auto flush() -> void;
+
+    // the output so far, only meaningful for growable buffers.
+    auto view() const -> std::string_view;
+
+    auto take() -> std::string;
+
+private:
+    auto before_value() -> void;
+
+    auto close_container(char c) -> void;
+
+    auto newline() -> void;
+
+    auto put(char c) -> void;
+
+    auto append(std::string_view data) -> void;
+
+    auto append_escaped(std::string_view string) -> void;
+
+    auto append_escape(unsigned char c) -> void;
+
+    auto append_unicode_escape(std::uint32_t unit) -> void;
+
+    auto reserve(std::size_t length) -> bool;
+
+private:
+    JsonWriterOptions m_options;
+    Sink m_sink;
+
+    std::string m_storage;
+    char* m_buffer{nullptr};
+    std::size_t m_capacity{0};
+    std::size_t m_size{0};
+
+    std::size_t m_depth{0};
+    bool m_needs_comma{false};
+    bool m_after_key{false};
+};